@@ -19,8 +19,8 @@ void ActionRecord::Apply(bool bDo, const Game& game, const Team& team, GameState
 
 void ActionRecord::Update(const Game& game, const Team& team, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateInfluenceTrack(team));
-	context.SendMessage(Output::UpdateActionTrack(team));
+	context.SendSharedMessage<Output::UpdateInfluenceTrack>(::EnumToString(team.GetColour()), team);
+	context.SendSharedMessage<Output::UpdateActionTrack>(::EnumToString(team.GetColour()), team);
 }
 
 std::string ActionRecord::GetTeamMessage() const
@@ -21,7 +21,7 @@ void AdvanceCombatTurnRecord::Apply(bool bDo, const Game& game, GameState& gameS
 void AdvanceCombatTurnRecord::Update(const Game& game, const RecordContext& context) const
 {
 	if (!game.GetBattle().IsFinished())
-		context.SendMessage(Output::UpdateCombat(game, game.GetBattle()));
+		context.SendSharedMessage<Output::UpdateCombat>("", game, game.GetBattle());
 }
 
 std::string AdvanceCombatTurnRecord::GetMessage(const Game& game) const
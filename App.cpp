@@ -3,6 +3,8 @@
 #include "Resources.h"
 #include "Hex.h"
 
+#include <thread>
+
 std::string FormatInt(int n)
 {
 	std::ostringstream ss;
@@ -41,6 +43,7 @@ SquareType ResourceToSquareType(Resource t)
 
 std::default_random_engine& GetRandom()
 { 
-	static std::default_random_engine engine((unsigned int)::time(nullptr) );
+	// Per thread, since games are loaded in parallel.
+	thread_local std::default_random_engine engine((unsigned int)::time(nullptr) ^ (unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id()));
 	return engine;
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include "AssetCache.h"
+#include "Deflater.h"
+
+#include <fstream>
+#include <iomanip>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	std::string LoadFile(const fs::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		return buffer.str();
+	}
+
+	bool IsPlaceholderChar(char c)
+	{
+		return (c >= 'A' && c <= 'Z') || c == '_';
+	}
+}
+
+AssetCache::Template::Template(const std::string& text)
+{
+	size_t start = 0; // Of the current literal.
+	for (size_t pos = text.find('%'); pos != std::string::npos; pos = text.find('%', pos + 1))
+	{
+		size_t end = pos + 1;
+		while (end < text.size() && IsPlaceholderChar(text[end]))
+			++end;
+		if (end == pos + 1 || end == text.size() || text[end] != '%')
+			continue;
+
+		m_literals.push_back(text.substr(start, pos - start));
+		m_names.push_back(text.substr(pos, end + 1 - pos));
+		start = end + 1;
+		pos = end;
+	}
+	m_literals.push_back(text.substr(start));
+}
+
+std::string AssetCache::Template::Render(const std::map<std::string, std::string>& values) const
+{
+	size_t size = 0;
+	for (auto& literal : m_literals)
+		size += literal.size();
+
+	std::string str;
+	str.reserve(size + 256);
+	str = m_literals.front();
+	for (size_t i = 0; i < m_names.size(); ++i)
+	{
+		auto it = values.find(m_names[i]);
+		str += it == values.end() ? m_names[i] : it->second;
+		str += m_literals[i + 1];
+	}
+	return str;
+}
+
+//-----------------------------------------------------------------------------
+
+AssetCache::Asset::Asset(const fs::path& path, fs::file_time_type _modified) :
+	content(LoadFile(path)), contentType(GetContentType(path)), modified(_modified), page(contentType == "text/html" ? content : "")
+{
+	if (IsText(contentType) && Deflater::IsAvailable())
+	{
+		gzipped = Deflater::Gzip(content);
+		if (gzipped.size() >= content.size())
+			gzipped.clear();
+	}
+
+	std::ostringstream ss;
+	ss << '"' << std::hex << std::hash<std::string>()(content) << '-' << content.size() << '"';
+	etag = ss.str();
+}
+
+AssetCache::AssetCache(const std::string& dir) : m_dir(dir)
+{
+	LoadAll();
+}
+
+void AssetCache::LoadAll()
+{
+	std::error_code ec;
+	for (auto it = fs::recursive_directory_iterator(m_dir, ec); it != fs::recursive_directory_iterator(); it.increment(ec))
+		if (it->is_regular_file(ec))
+		{
+			std::string url = "/" + fs::relative(it->path(), m_dir, ec).generic_string();
+			m_assets[url] = std::make_shared<Asset>(it->path(), it->last_write_time(ec));
+		}
+
+	std::cout << "INFO: Loaded " << m_assets.size() << " assets from " << m_dir << std::endl;
+}
+
+AssetCache::AssetPtr AssetCache::Find(const std::string& url) const
+{
+	LOCK(m_mutex);
+
+	auto it = m_assets.find(url);
+	if (it == m_assets.end())
+		return nullptr;
+
+	// Reload if it's changed since.
+	const fs::path path = m_dir / fs::u8path(url.substr(1));
+	std::error_code ec;
+	const fs::file_time_type modified = fs::last_write_time(path, ec);
+	if (ec)
+	{
+		m_assets.erase(it);
+		return nullptr;
+	}
+	if (modified != it->second->modified)
+	{
+		std::cout << "INFO: Reloading asset: " << url << std::endl;
+		it->second = std::make_shared<Asset>(path, modified);
+	}
+	return it->second;
+}
+
+std::string AssetCache::GetContentType(const fs::path& path)
+{
+	static const std::map<std::string, std::string> types = 
+	{
+		{ ".html", "text/html" },
+		{ ".js", "application/javascript" },
+		{ ".css", "text/css" },
+		{ ".json", "application/json" },
+		{ ".svg", "image/svg+xml" },
+		{ ".png", "image/png" },
+		{ ".jpg", "image/jpeg" },
+		{ ".gif", "image/gif" },
+		{ ".ico", "image/x-icon" },
+	};
+
+	auto it = types.find(path.extension().string());
+	return it == types.end() ? "application/octet-stream" : it->second;
+}
+
+bool AssetCache::IsText(const std::string& contentType)
+{
+	return contentType.compare(0, 5, "text/") == 0 || contentType == "application/javascript" || contentType == "application/json" || contentType == "image/svg+xml";
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The files under a directory, loaded at startup and reloaded when they change on disk.
+// Text files also get a gzipped copy (if we've got zlib). 
+class AssetCache
+{
+public:
+	// A page split at its %NAME% placeholders, so rendering is just concatenation.
+	class Template
+	{
+	public:
+		Template(const std::string& text);
+		std::string Render(const std::map<std::string, std::string>& values) const; // Unknown placeholders are left as they are.
+	private:
+		std::vector<std::string> m_literals; // One more than m_names.
+		std::vector<std::string> m_names;
+	};
+
+	struct Asset
+	{
+		Asset(const std::filesystem::path& path, std::filesystem::file_time_type modified);
+
+		std::string content, gzipped; // gzipped is empty if it wouldn't help.
+		std::string contentType, etag;
+		std::filesystem::file_time_type modified;
+		Template page; // Only for HTML.
+	};
+	typedef std::shared_ptr<const Asset> AssetPtr;
+
+	AssetCache(const std::string& dir);
+
+	AssetPtr Find(const std::string& url) const; // Null if there's no such file.
+
+private:
+	void LoadAll();
+	static std::string GetContentType(const std::filesystem::path& path);
+	static bool IsText(const std::string& contentType);
+
+	std::filesystem::path m_dir;
+	mutable std::map<std::string, AssetPtr> m_assets; // By URL.
+	mutable std::mutex m_mutex;
+};
@@ -55,7 +55,7 @@ void AttackPopulationRecord::Apply(bool bDo, const Game& game, GameState& gameSt
 void AttackPopulationRecord::Update(const Game& game, const RecordContext& context) const
 {
 	if (!m_hits.empty())
-		context.SendMessage(Output::UpdateMap(context.GetGame()));
+		context.SendMapDelta();
 }
 
 std::string AttackPopulationRecord::GetMessage(const Game& game) const
@@ -62,10 +62,10 @@ void AttackShipsRecord::Apply(bool bDo, const Game& game, GameState& gameState)
 
 void AttackShipsRecord::Update(const Game& game, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateCombat(context.GetGame(), game.GetBattle()));
+	context.SendSharedMessage<Output::UpdateCombat>("", context.GetGame(), game.GetBattle());
 
 	if (!m_killIndices.empty())
-		context.SendMessage(Output::UpdateMap(context.GetGame()));
+		context.SendMapDelta();
 }
 
 std::string AttackShipsRecord::GetMessage(const Game& game) const
@@ -28,7 +28,7 @@ std::vector<MapPos> AutoInfluenceCmd::GetHexes(const LiveGame& game) const
 
 	std::vector<MapPos> hexes;
 
-	for (auto& kv : game.GetMap().GetHexes())
+	for (auto kv : game.GetMap().GetHexes())
 	{
 		auto& hex = kv.second;
 		if (GetAutoInfluenceColour(*hex) == m_colour)
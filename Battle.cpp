@@ -6,6 +6,7 @@
 #include "LiveGame.h"
 #include "Test.h"
 #include "Record.h"
+#include "StateHash.h"
 
 Battle::Group::Group() : shipType(ShipType::None), invader(false), hasMissiles(false) 
 {
@@ -117,6 +118,17 @@ bool Battle::operator==(const Battle& rhs) const
 	return false;
 }
 
+uint64_t Battle::GetHash() const
+{
+	StateHash hash;
+	hash.Add(IsPopulationBattle()).Add(m_defender).Add(m_invader).Add(m_hexId);
+	hash.Add((int)m_groups.size());
+	for (auto& group : m_groups)
+		hash.Add(group.shipType).Add(group.invader).Add(group.hasMissiles);
+	hash.Add(m_turn.groupIndex).Add(m_turn.phase);
+	return hash.Get();
+}
+
 void Battle::AddGroups(bool invader, const Hex& hex, const Game& game)
 {
 	for (auto shipType : AllShipTypesRange())
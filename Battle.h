@@ -5,6 +5,7 @@
 
 #include "libKernel/Dynamic.h"
 
+#include <cstdint>
 #include <vector>
 #include <map>
 
@@ -62,6 +63,7 @@ public:
 	Battle();
 	Battle(const Hex& hex, const Game& game, const GroupVec& oldGroups);
 	virtual bool operator==(const Battle& rhs) const;
+	uint64_t GetHash() const; // Covers the same state as operator==.
 	virtual BattlePtr Clone() const = 0;
 
 	int GetHexId() const { return m_hexId; }
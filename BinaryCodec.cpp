@@ -0,0 +1,577 @@
+#include "stdafx.h"
+#include "BinaryCodec.h"
+#include "Team.h"
+#include "Race.h"
+#include "Ship.h"
+#include "ShipLayout.h"
+#include "Resources.h"
+#include "Technology.h"
+#include "Discovery.h"
+#include "Types.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	enum class Tag : unsigned char { Null, False, True, Int, Double, String, Word, Array, Object, Points };
+
+	// Common keys and values. Anything else is sent as a string.
+	const char* Keys[] = 
+	{
+		"action", "action_track", "active", "active_player_id", "add_log", "advance_review", "ambassador", "available",
+		"base_layout", "base_version", "before", "binary", "blueprints", "build", "buildable", "can_abort", "can_advance",
+		"can_build", "can_build_monolith", "can_build_orbital", "can_colonise", "can_diplomacy", "can_end_turn",
+		"can_explore", "can_fire", "can_influence", "can_keep", "can_move", "can_pass", "can_remove", "can_research",
+		"can_retreat", "can_select_track", "can_skip", "can_start", "can_take", "can_trade", "can_undo", "can_upgrade",
+		"can_use", "changes", "chat", "choose", "choose_panel", "choose_team", "classes", "cmd_abort", "cmd_auto_influence",
+		"cmd_build", "cmd_colonise_pos", "cmd_colonise_squares", "cmd_combat", "cmd_dice", "cmd_diplomacy", "cmd_discovery",
+		"cmd_explore_hex", "cmd_explore_hex_take", "cmd_explore_pos", "cmd_influence_dst",
+		"cmd_influence_flip", "cmd_influence_src", "cmd_move_dst", "cmd_move_src", "cmd_research", "cmd_research_artifact",
+		"cmd_trade", "cmd_uncolonise", "cmd_upgrade", "codec", "colonise_pos", "colonise_squares", "colony_ships", "colour",
+		"combat", "command", "commit", "cost", "count", "create_game", "current_players", "cursor", "defender", "dice",
+		"diplomacy", "discovery", "discs", "enable", "enter_game", "epoch", "exit_game", "exit_review", "explore_hex",
+		"fetch_logs", "fetch_map", "finish_upkeep", "finished", "fire", "fixed_power", "from", "game", "game_list",
+		"game_list_entry", "game_list_panel", "game_panel", "game_type", "group", "has_joined", "has_passed", "hex", "hex_idx", "hexes", "id",
+		"influence", "influence_track", "invader", "is_ancient", "is_bankrupt", "is_drive", "is_owner", "items", "join_game",
+		"last_seq", "lobby", "lobby_controls", "lobby_panel", "map", "map_delta", "max_cost", "max_cubes", "max_flips",
+		"max_lives", "max_upgrades", "message", "min_cost", "mine", "missiles", "monolith", "move_dst", "move_src", "msgs",
+		"name", "next_record_id", "open", "other", "overlay", "owner", "panel", "param", "part", "parts", "passed", "player",
+		"players", "population_track", "pos_idx", "positions", "power_drain", "power_source", "prepend_log",
+		"query_blueprint_stats", "race", "rate", "record_id", "register", "remove_log", "removed", "reputation",
+		"reputation_track", "research", "research_artifact", "response", "retreat_review", "review_ui", "rot_idx",
+		"rotation", "rotations", "round", "round_count", "score", "seek_review", "selected", "send_values", "seq", "session",
+		"ship", "ship_groups", "ships", "show", "show_combat", "slot", "slots", "square_counts", "squares", "start_action",
+		"start_game", "start_review", "storage", "storage_track", "team", "teams", "tech_idx", "technologies", "technology",
+		"technology_track", "techs", "tiles", "to", "total", "trade", "traitor", "type", "uncolonise", "undo", "unjoin_game",
+		"update", "upgrade", "upkeep", "used", "values", "version", "victory_point_tiles", "victory_tiles", "words", "x",
+		"y", nullptr
+	};
+
+	struct Dictionary
+	{
+		template <typename T>
+		void AddEnum()
+		{
+			for (auto e : EnumRange<T>())
+				Add(::EnumToString(e));
+		}
+
+		void Add(const std::string& word)
+		{
+			if (!word.empty() && indices.insert(std::make_pair(word, (int)words.size())).second)
+				words.push_back(word);
+		}
+
+		std::vector<std::string> words;
+		std::unordered_map<std::string, int> indices;
+	};
+
+	const Dictionary& GetDict()
+	{
+		static const Dictionary dict = []
+		{
+			Dictionary d;
+			for (const char** key = Keys; *key; ++key)
+				d.Add(*key);
+
+			d.AddEnum<Colour>();
+			d.AddEnum<RaceType>();
+			d.AddEnum<ShipType>();
+			d.AddEnum<ShipPart>();
+			d.AddEnum<Resource>();
+			d.AddEnum<SquareType>();
+			d.AddEnum<TechType>();
+			d.AddEnum<Technology::Class>();
+			d.AddEnum<DiscoveryType>();
+			return d;
+		}();
+		return dict;
+	}
+
+	void WriteVarint(std::string& out, uint64_t n)
+	{
+		for (; n >= 0x80; n >>= 7)
+			out += char((n & 0x7f) | 0x80);
+		out += char(n);
+	}
+
+	void WriteInt(std::string& out, int64_t n)
+	{
+		WriteVarint(out, n < 0 ? ~(uint64_t(n) << 1) : uint64_t(n) << 1);
+	}
+
+	void EncodeString(std::string& out, const std::string& str)
+	{
+		auto& indices = GetDict().indices;
+		auto it = indices.find(str);
+		if (it != indices.end())
+		{
+			out += char(Tag::Word);
+			WriteVarint(out, it->second);
+			return;
+		}
+		out += char(Tag::String);
+		WriteVarint(out, str.size());
+		out += str;
+	}
+
+	void AppendUTF8(std::string& out, uint32_t c)
+	{
+		if (c < 0x80)
+			out += char(c);
+		else if (c < 0x800)
+		{
+			out += char(0xc0 | (c >> 6));
+			out += char(0x80 | (c & 0x3f));
+		}
+		else if (c < 0x10000)
+		{
+			out += char(0xe0 | (c >> 12));
+			out += char(0x80 | ((c >> 6) & 0x3f));
+			out += char(0x80 | (c & 0x3f));
+		}
+		else
+		{
+			out += char(0xf0 | (c >> 18));
+			out += char(0x80 | ((c >> 12) & 0x3f));
+			out += char(0x80 | ((c >> 6) & 0x3f));
+			out += char(0x80 | (c & 0x3f));
+		}
+	}
+
+	// Parses JSON text, writing the binary form as it goes.
+	class Encoder
+	{
+	public:
+		Encoder(const std::string& json) : m_json(json), m_pos(0) {}
+
+		std::string Encode()
+		{
+			EncodeValue(m_out);
+			SkipSpace();
+			VERIFY_MSG("BinaryCodec: trailing characters", m_pos == m_json.size());
+			return std::move(m_out);
+		}
+
+	private:
+		char Peek() { SkipSpace(); return m_pos < m_json.size() ? m_json[m_pos] : 0; }
+		bool Accept(char c) { if (Peek() != c) return false; ++m_pos; return true; }
+		void Expect(char c) { VERIFY_MSG("BinaryCodec: bad JSON", Accept(c)); }
+
+		void SkipSpace()
+		{
+			while (m_pos < m_json.size() && std::isspace((unsigned char)m_json[m_pos]))
+				++m_pos;
+		}
+
+		void EncodeValue(std::string& out)
+		{
+			switch (Peek())
+			{
+			case '{': EncodeObject(out); break;
+			case '[': EncodeArray(out); break;
+			case '"': EncodeString(out, ParseString()); break;
+			case 't': ExpectWord("true"); out += char(Tag::True); break;
+			case 'f': ExpectWord("false"); out += char(Tag::False); break;
+			case 'n': ExpectWord("null"); out += char(Tag::Null); break;
+			default: EncodeNumber(out);
+			}
+		}
+
+		void EncodeObject(std::string& out)
+		{
+			Expect('{');
+			std::string members;
+			uint64_t count = 0;
+			if (!Accept('}'))
+			{
+				do
+				{
+					EncodeString(members, ParseString());
+					Expect(':');
+					EncodeValue(members);
+					++count;
+				} while (Accept(','));
+				Expect('}');
+			}
+			out += char(Tag::Object);
+			WriteVarint(out, count);
+			out += members;
+		}
+
+		void EncodeArray(std::string& out)
+		{
+			if (EncodePoints(out))
+				return;
+
+			Expect('[');
+			std::string items;
+			uint64_t count = 0;
+			if (!Accept(']'))
+			{
+				do
+				{
+					EncodeValue(items);
+					++count;
+				} while (Accept(','));
+				Expect(']');
+			}
+			out += char(Tag::Array);
+			WriteVarint(out, count);
+			out += items;
+		}
+
+		// An array of {"x":int,"y":int} objects, as AppendPointElement writes them. 
+		bool EncodePoints(std::string& out)
+		{
+			const size_t start = m_pos;
+			std::string points;
+			uint64_t count = 0;
+
+			Expect('[');
+			do
+			{
+				int64_t x, y;
+				if (!(Accept('{') && AcceptKey("x") && ParseInt(x) && Accept(',') && AcceptKey("y") && ParseInt(y) && Accept('}')))
+				{
+					m_pos = start;
+					return false;
+				}
+				WriteInt(points, x);
+				WriteInt(points, y);
+				++count;
+			} while (Accept(','));
+
+			if (!Accept(']'))
+			{
+				m_pos = start;
+				return false;
+			}
+
+			out += char(Tag::Points);
+			WriteVarint(out, count);
+			out += points;
+			return true;
+		}
+
+		bool AcceptKey(const char* key)
+		{
+			const size_t len = std::strlen(key);
+			if (Peek() != '"' || m_json.compare(m_pos + 1, len + 1, std::string(key) + '"') != 0)
+				return false;
+			m_pos += len + 2;
+			return Accept(':');
+		}
+
+		bool ParseInt(int64_t& n)
+		{
+			SkipSpace();
+			const char* begin = m_json.c_str() + m_pos;
+			char* end = nullptr;
+			errno = 0;
+			n = std::strtoll(begin, &end, 10);
+			if (end == begin || errno || *end == '.' || *end == 'e' || *end == 'E')
+				return false;
+			m_pos += end - begin;
+			return true;
+		}
+
+		void EncodeNumber(std::string& out)
+		{
+			int64_t n;
+			if (ParseInt(n))
+			{
+				out += char(Tag::Int);
+				WriteInt(out, n);
+				return;
+			}
+
+			const char* begin = m_json.c_str() + m_pos;
+			char* end = nullptr;
+			double d = std::strtod(begin, &end);
+			VERIFY_MSG("BinaryCodec: bad JSON", end != begin);
+			m_pos += end - begin;
+
+			char bytes[8];
+			std::memcpy(bytes, &d, 8); // We only run little endian.
+			out += char(Tag::Double);
+			out.append(bytes, 8);
+		}
+
+		void ExpectWord(const char* word)
+		{
+			const size_t len = std::strlen(word);
+			VERIFY_MSG("BinaryCodec: bad JSON", m_json.compare(m_pos, len, word) == 0);
+			m_pos += len;
+		}
+
+		std::string ParseString()
+		{
+			Expect('"');
+			std::string str;
+			while (true)
+			{
+				VERIFY_MSG("BinaryCodec: unterminated string", m_pos < m_json.size());
+				char c = m_json[m_pos++];
+				if (c == '"')
+					return str;
+				if (c != '\\')
+				{
+					str += c;
+					continue;
+				}
+
+				VERIFY_MSG("BinaryCodec: bad escape", m_pos < m_json.size());
+				switch (c = m_json[m_pos++])
+				{
+				case 'b': str += '\b'; break;
+				case 'f': str += '\f'; break;
+				case 'n': str += '\n'; break;
+				case 'r': str += '\r'; break;
+				case 't': str += '\t'; break;
+				case 'u': 
+				{
+					uint32_t code = ParseHex4();
+					if (code >= 0xd800 && code < 0xdc00 && m_json.compare(m_pos, 2, "\\u") == 0) // Surrogate pair.
+					{
+						m_pos += 2;
+						code = 0x10000 + ((code - 0xd800) << 10) + (ParseHex4() - 0xdc00);
+					}
+					AppendUTF8(str, code);
+					break;
+				}
+				default: str += c; // '"', '\\', '/'.
+				}
+			}
+		}
+
+		uint32_t ParseHex4()
+		{
+			VERIFY_MSG("BinaryCodec: bad escape", m_pos + 4 <= m_json.size());
+			uint32_t code = std::stoul(m_json.substr(m_pos, 4), nullptr, 16);
+			m_pos += 4;
+			return code;
+		}
+
+		const std::string& m_json;
+		size_t m_pos;
+		std::string m_out;
+	};
+
+	// Writes JSON text from the binary form. The input comes from clients, so check everything.
+	class Decoder
+	{
+	public:
+		Decoder(const std::string& binary) : m_bin(binary), m_pos(0) {}
+
+		std::string Decode()
+		{
+			DecodeValue(0);
+			VERIFY_INPUT_MSG("BinaryCodec: trailing bytes", m_pos == m_bin.size());
+			return std::move(m_out);
+		}
+
+	private:
+		static const int MaxDepth = 64;
+
+		unsigned char ReadByte()
+		{
+			VERIFY_INPUT_MSG("BinaryCodec: truncated", m_pos < m_bin.size());
+			return (unsigned char)m_bin[m_pos++];
+		}
+
+		uint64_t ReadVarint()
+		{
+			uint64_t n = 0;
+			for (int shift = 0; ; shift += 7)
+			{
+				VERIFY_INPUT_MSG("BinaryCodec: bad varint", shift < 64);
+				unsigned char b = ReadByte();
+				n |= uint64_t(b & 0x7f) << shift;
+				if (!(b & 0x80))
+					return n;
+			}
+		}
+
+		int64_t ReadInt()
+		{
+			uint64_t n = ReadVarint();
+			return n & 1 ? ~int64_t(n >> 1) : int64_t(n >> 1);
+		}
+
+		size_t ReadCount()
+		{
+			uint64_t count = ReadVarint();
+			VERIFY_INPUT_MSG("BinaryCodec: bad count", count <= m_bin.size() - m_pos); // Every item is at least a byte.
+			return (size_t)count;
+		}
+
+		void DecodeValue(int depth)
+		{
+			VERIFY_INPUT_MSG("BinaryCodec: too deep", depth < MaxDepth);
+
+			switch (Tag(ReadByte()))
+			{
+			case Tag::Null: m_out += "null"; break;
+			case Tag::False: m_out += "false"; break;
+			case Tag::True: m_out += "true"; break;
+			case Tag::Int: m_out += std::to_string(ReadInt()); break;
+			case Tag::Double:
+			{
+				VERIFY_INPUT_MSG("BinaryCodec: truncated", m_pos + 8 <= m_bin.size());
+				double d;
+				std::memcpy(&d, m_bin.data() + m_pos, 8);
+				m_pos += 8;
+				VERIFY_INPUT_MSG("BinaryCodec: bad double", std::isfinite(d));
+				std::ostringstream ss;
+				ss.precision(17);
+				ss << d;
+				m_out += ss.str();
+				break;
+			}
+			case Tag::String:
+			{
+				size_t len = ReadCount();
+				WriteString(m_bin.substr(m_pos, len));
+				m_pos += len;
+				break;
+			}
+			case Tag::Word:
+				WriteWord();
+				break;
+			case Tag::Array:
+			{
+				m_out += '[';
+				for (size_t i = 0, count = ReadCount(); i < count; ++i)
+				{
+					if (i)
+						m_out += ',';
+					DecodeValue(depth + 1);
+				}
+				m_out += ']';
+				break;
+			}
+			case Tag::Object:
+			{
+				m_out += '{';
+				for (size_t i = 0, count = ReadCount(); i < count; ++i)
+				{
+					if (i)
+						m_out += ',';
+					DecodeKey();
+					m_out += ':';
+					DecodeValue(depth + 1);
+				}
+				m_out += '}';
+				break;
+			}
+			case Tag::Points:
+			{
+				m_out += '[';
+				for (size_t i = 0, count = ReadCount(); i < count; ++i)
+				{
+					if (i)
+						m_out += ',';
+					m_out += "{\"x\":" + std::to_string(ReadInt());
+					m_out += ",\"y\":" + std::to_string(ReadInt()) + '}';
+				}
+				m_out += ']';
+				break;
+			}
+			default:
+				VERIFY_INPUT_MSG("BinaryCodec: bad tag", false);
+			}
+		}
+
+		void DecodeKey()
+		{
+			Tag tag = Tag(ReadByte());
+			if (tag == Tag::Word)
+				WriteWord();
+			else
+			{
+				VERIFY_INPUT_MSG("BinaryCodec: bad key", tag == Tag::String);
+				size_t len = ReadCount();
+				WriteString(m_bin.substr(m_pos, len));
+				m_pos += len;
+			}
+		}
+
+		void WriteWord()
+		{
+			auto& words = GetDict().words;
+			uint64_t index = ReadVarint();
+			VERIFY_INPUT_MSG("BinaryCodec: bad word", index < words.size());
+			WriteString(words[(size_t)index]);
+		}
+
+		void WriteString(const std::string& str)
+		{
+			m_out += '"';
+			for (char c : str)
+			{
+				if (c == '"' || c == '\\')
+					(m_out += '\\') += c;
+				else if ((unsigned char)c < 0x20)
+				{
+					char esc[8];
+					std::snprintf(esc, sizeof esc, "\\u%04x", c);
+					m_out += esc;
+				}
+				else
+					m_out += c;
+			}
+			m_out += '"';
+		}
+
+		const std::string& m_bin;
+		size_t m_pos;
+		std::string m_out;
+	};
+}
+
+namespace BinaryCodec
+{
+
+std::string Encode(const std::string& json)
+{
+	return Encoder(json).Encode();
+}
+
+std::string Decode(const std::string& binary)
+{
+	return Decoder(binary).Decode();
+}
+
+// Encode would only differ for an array of {"x", "y"} objects, which it writes as Points. Messages are never that.
+std::string EncodeArray(const std::vector<const std::string*>& items)
+{
+	std::string out(1, char(Tag::Array));
+	WriteVarint(out, items.size());
+	for (auto* item : items)
+		out += *item;
+	return out;
+}
+
+std::string EncodeFrame(int seq, const std::string& msgs)
+{
+	std::string out(1, char(Tag::Object));
+	WriteVarint(out, 2);
+	EncodeString(out, "seq");
+	out += char(Tag::Int);
+	WriteInt(out, seq);
+	EncodeString(out, "msgs");
+	return out + msgs;
+}
+
+const std::vector<std::string>& GetDictionary()
+{
+	return GetDict().words;
+}
+
+} // namespace
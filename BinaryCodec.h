@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A compact binary form of our JSON messages, for clients that ask for it when they register.
+// Each value is a tag byte followed by:
+//   Int: zigzag varint. Double: 8 bytes, little endian. String: varint length, UTF-8 bytes.
+//   Word: varint index into the dictionary of keys and enum names, which the client gets when it registers.
+//   Array, Object: varint count, then the values (or key/value pairs). 
+//   Points: varint count, then zigzag varint x and y for each {"x", "y"} object.
+namespace BinaryCodec
+{
+	std::string Encode(const std::string& json);
+	std::string Decode(const std::string& binary); // To JSON, for Input.
+
+	// Built from values that are already encoded, so a message sent to many players is only encoded once.
+	std::string EncodeArray(const std::vector<const std::string*>& items);
+	std::string EncodeFrame(int seq, const std::string& msgs); // {"seq":seq,"msgs":msgs}, as ReplayBuffer frames them.
+
+	const std::vector<std::string>& GetDictionary();
+}
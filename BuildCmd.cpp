@@ -104,7 +104,7 @@ private:
 
 	virtual void Update(const Game& game, const Team& team, const RecordContext& context) const override
 	{
-		context.SendMessage(Output::UpdateMap(game));
+		context.SendMapDelta();
 		context.SendMessage(Output::UpdateStorageTrack(team));
 	}
 
@@ -137,7 +137,7 @@ void BuildCmd::UpdateClient(const Controller& controller, const LiveGame& game)
 
 	std::map<MapPos, std::pair<bool, bool>> hexes; // (orbital, monolith)
 
-	for (auto& h : game.GetMap().GetHexes()) // Pos, hex.
+	for (auto h : game.GetMap().GetHexes()) // Pos, hex.
 		if (h.second->GetColour() == m_colour)
 			hexes[h.first] = std::make_pair(!h.second->HasOrbital() && CanBuild(team, Buildable::Orbital),
 											!h.second->HasMonolith() && CanBuild(team, Buildable::Monolith));
@@ -18,7 +18,7 @@ std::vector<MapPos> ColoniseCmd::GetPositions(const LiveGame& game) const
 {
 	std::vector<MapPos> positions;
 	const Team& team = GetTeam(game);
-	for (auto& h : game.GetMap().GetHexes())
+	for (auto h : game.GetMap().GetHexes())
 		if (h.second->IsOwnedBy(team))
 			if (!h.second->GetAvailableSquares(team).empty()) // TODO: Check pop cubes
 				positions.push_back(h.first);
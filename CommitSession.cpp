@@ -9,9 +9,9 @@
 
 // All non-const LiveGame access should be performed during a CommitSession. 
 // If an exception occurs between opening and committing the session, the game may be in an invalid state and should be locked. 
-// Nesting is not allowed. 
+// Nesting is not allowed on one thread; sessions for different games may run concurrently on their own lanes. 
 
-CommitSession* CommitSession::s_pInstance;
+thread_local CommitSession* CommitSession::s_pInstance;
 
 CommitSession::CommitSession(const LiveGame& game, const Controller& controller) : 
 m_game(const_cast<LiveGame&>(game)), m_controller(controller), m_bCommitted(), m_lock(game.GetMutex(), std::defer_lock),
@@ -37,6 +37,7 @@ LiveGame& CommitSession::Open()
 			std::cout << "Waiting for game mutex..." << std::endl;
 			m_lock.lock();
 		}
+	Controller::OnGameChanged(m_game);
 	return m_game; 
 }
 
@@ -68,8 +69,10 @@ void CommitSession::DoAndPushRecord(RecordPtr pRec)
 	int id = m_game.PushRecord(std::move(pRec));
 
 	ASSERT(!msg.empty());
+	m_game.GetLogCache().Add(id, msg);
 
-	Output::AddLog output(id, msg);
+	// Serialised once for every game.
+	auto output = std::make_shared<std::string>(Output::AddLog(id, msg).GetXML());
 	m_controller.SendMessage(output, m_game);
 	
 	for (auto& g : m_game.GetReviewGames())
@@ -84,7 +87,9 @@ RecordPtr CommitSession::PopAndUndoRecord()
 
 	m_bUpdateReviewUI |= !pRec->IsMessageRecord();
 
-	Output::RemoveLog output(pRec->GetID());
+	m_game.GetLogCache().Remove(pRec->GetID());
+
+	auto output = std::make_shared<std::string>(Output::RemoveLog(pRec->GetID()).GetXML());
 	m_controller.SendMessage(output, m_game);
 
 	for (auto& g : m_game.GetReviewGames())
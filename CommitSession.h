@@ -30,7 +30,7 @@ public:
 private:
 	LiveGame& m_game;
 	const Controller& m_controller;
-	static CommitSession* s_pInstance;
+	static thread_local CommitSession* s_pInstance; // One per lane.
 	bool m_bOpened, m_bCommitted, m_bUpdateReviewUI;
 	std::unique_lock<std::mutex> m_lock;
 };
@@ -8,28 +8,55 @@
 #include "ReviewGame.h"
 #include "ActionPhase.h"
 #include "ChooseTeamPhase.h"
+#include "LogCache.h"
+#include "GameDirectory.h"
+#include "BinaryCodec.h"
 
 #include "App.h"
 
+#include <ctime>
+
 SINGLETON(Controller)
 
-Controller::Controller()
+const int Controller::ReplayGraceSeconds = 5 * 60;
+
+namespace
+{
+	// Messages are processed on several threads at once, so each queues its own output.
+	thread_local std::map<const Player*, std::vector<std::shared_ptr<std::string>>> s_messages;
+	thread_local std::map<const Game*, std::map<std::string, std::shared_ptr<std::string>>> s_sharedMessages; // Cleared on flush.
+	thread_local std::map<const std::string*, std::string> s_binaryMessages; // Of messages in s_messages, encoded once each.
+}
+
+Controller::Controller() : m_pServer(nullptr), m_epoch((int)std::time(nullptr))
 {
 }
 
-void Controller::SendUpdateGameList(const Player* pPlayer) const
+void Controller::SendUpdateGameList(const Player& player) const
 {
+	SendMessage(Output::UpdateGameList(GameDirectory::GetEntries(), player), player);
+}
+
+// Only two versions of the message, however many players there are: for those who've joined the game, and for everyone else.
+void Controller::SendUpdateGameListEntry(const LiveGame& game) const
+{
+	auto pEntry = GameDirectory::Update(game);
+
+	StringPtr msgs[2]; // Not mine, mine.
 	for (auto& player : m_pServer->GetPlayers())
-		if (!pPlayer || pPlayer == player)
-			SendMessage(std::make_shared<std::string>(Output::UpdateGameList(*player).GetXML()), *player);
+	{
+		const bool bMine = pEntry->IsMine(*player);
+		if (!msgs[bMine])
+			msgs[bMine] = std::make_shared<std::string>(Output::UpdateGameListEntry(*pEntry, bMine).GetXML());
+		SendMessage(msgs[bMine], *player);
+	}
 }
 
+// The caller sends the queued messages, along with its response.
 void Controller::OnMessage(const Input::MessagePtr& pMsg, Player& player)
 {
 	bool bOK = pMsg->Process(*this, player);
 	ASSERT(bOK);
-
-	SendQueuedMessages();
 }
 
 void Controller::SendMessage(const Output::Message& msg, const Player& player) const
@@ -39,12 +66,16 @@ void Controller::SendMessage(const Output::Message& msg, const Player& player) c
 
 void Controller::SendMessage(StringPtr msg, const Player& player) const
 {
-	m_messages[&player].push_back(msg);
+	s_messages[&player].push_back(msg);
 }
 
 void Controller::SendMessage(const Output::Message& msg, const Game& game, const Player* pPlayer) const
 {
-	StringPtr str = std::make_shared<std::string>(msg.GetXML());
+	SendMessage(std::make_shared<std::string>(msg.GetXML()), game, pPlayer);
+}
+
+void Controller::SendMessage(StringPtr str, const Game& game, const Player* pPlayer) const
+{
 	if (!pPlayer)
 	{
 		for (auto& player : game.GetCurrentPlayers())
@@ -57,27 +88,153 @@ void Controller::SendMessage(const Output::Message& msg, const Game& game, const
 	}
 }
 
+Controller::StringPtr Controller::GetSharedMessage(const Game& game, const std::string& key, const std::function<std::string()>& build) const
+{
+	auto& msg = s_sharedMessages[&game][key];
+	if (!msg)
+		msg = std::make_shared<std::string>(build());
+	return msg;
+}
+
+void Controller::SendSecretMessage(const Game& game, const std::string& key, const Player& owner, const Player* pPlayer, const std::function<std::string(bool)>& build) const
+{
+	auto send = [&](const Player& dst)
+	{
+		const bool bOwner = &dst == &owner;
+		SendMessage(GetSharedMessage(game, key + (bOwner ? "/owner" : "/others"), [&] { return build(bOwner); }), game, &dst);
+	};
+
+	if (pPlayer)
+		send(*pPlayer);
+	else
+		for (auto& player : game.GetCurrentPlayers())
+			send(*player);
+}
+
+void Controller::OnGameChanged(const Game& game)
+{
+	s_sharedMessages.erase(&game);
+}
+
+// Each player's messages go in one numbered frame, as a JSON array. 
 void Controller::SendQueuedMessages()
 {
-	for (auto& playerMsgs : m_messages)
-		for (auto& msg : playerMsgs.second)
-			m_pServer->SendMessage(*msg, *playerMsgs.first);
-	m_messages.clear();
+	for (auto& playerMsgs : s_messages)
+	{
+		auto& msgs = playerMsgs.second;
+
+		size_t size = msgs.size() + 1;
+		for (auto& msg : msgs)
+			size += msg->size();
+
+		std::string batch;
+		batch.reserve(size);
+		for (auto& msg : msgs)
+		{
+			batch += batch.empty() ? '[' : ',';
+			batch += *msg;
+		}
+		batch += ']';
+
+		std::string binary;
+		if (m_pServer->IsBinary(*playerMsgs.first))
+		{
+			std::vector<const std::string*> encoded;
+			for (auto& msg : msgs)
+			{
+				std::string& bin = s_binaryMessages[msg.get()];
+				if (bin.empty())
+					bin = BinaryCodec::Encode(*msg);
+				encoded.push_back(&bin);
+			}
+			binary = BinaryCodec::EncodeArray(encoded);
+		}
+
+		SendFrame(batch, binary, *playerMsgs.first);
+	}
+	ClearQueuedMessages();
 }
 
 void Controller::ClearQueuedMessages()
 {
-	m_messages.clear();
+	s_messages.clear();
+	s_sharedMessages.clear();
+	s_binaryMessages.clear();
 }
 
-void Controller::OnPlayerConnected(Player& player)
+Controller::ReplayBufferPtr Controller::GetReplayBuffer(const Player& player) const
 {
+	LOCK(m_replayMutex);
+	auto it = m_replayBuffers.find(&player);
+	return it == m_replayBuffers.end() ? nullptr : it->second.pBuffer;
+}
+
+void Controller::EvictReplayBuffers()
+{
+	const auto cutoff = std::chrono::steady_clock::now() - std::chrono::seconds(ReplayGraceSeconds);
+	for (auto it = m_replayBuffers.begin(); it != m_replayBuffers.end();)
+		if (!it->second.bConnected && it->second.disconnected < cutoff)
+			it = m_replayBuffers.erase(it);
+		else
+			++it;
+}
+
+// Frames are kept while the player's briefly disconnected, so they can be resent when they're back. 
+void Controller::SendFrame(const std::string& msgs, const std::string& binaryMsgs, const Player& player)
+{
+	ReplayBufferPtr pBuffer = GetReplayBuffer(player);
+	if (!pBuffer)
+		return; // They'll get everything when they reconnect.
+
+	LOCK(pBuffer->GetMutex());
+
+	std::string frame;
+	const int seq = pBuffer->Add(msgs, frame);
+	m_pServer->SendMessage(frame, player, binaryMsgs.empty() ? std::string() : BinaryCodec::EncodeFrame(seq, binaryMsgs));
+}
+
+bool Controller::ResendFrames(const Player& player, int lastSeq)
+{
+	ReplayBufferPtr pBuffer = GetReplayBuffer(player);
+	LOCK(pBuffer->GetMutex());
+
+	std::vector<std::string> frames;
+	if (!pBuffer->GetFramesAfter(lastSeq, frames))
+		return false;
+
+	for (auto& frame : frames)
+		m_pServer->SendMessage(frame, player);
+
+	std::cout << "INFO: Resent " << frames.size() << " frame(s) to " << player.GetName() << std::endl;
+	return true;
+}
+
+void Controller::OnPlayerConnected(Player& player, int epoch, int lastSeq)
+{
+	bool bNewBuffer = false; // Gone, or never had one: the client needs everything.
+	{
+		LOCK(m_replayMutex);
+		ReplayEntry& entry = m_replayBuffers[&player];
+		if (!entry.pBuffer)
+		{
+			entry.pBuffer = std::make_shared<ReplayBuffer>();
+			bNewBuffer = true;
+		}
+		entry.bConnected = true;
+		EvictReplayBuffers();
+	}
+
+	if (epoch == m_epoch && !bNewBuffer && ResendFrames(player, lastSeq))
+		return;
+
+	SendMessage(Output::UpdateSession(m_epoch), player);
+
 	if (const Game* pGame = player.GetCurrentGame())
 		SendUpdateGame(*pGame, &player);
 	else
 	{
 		SendMessage(Output::ShowGameList(), player);
-		SendUpdateGameList(&player);
+		SendUpdateGameList(player);
 	}
 
 	SendQueuedMessages();
@@ -85,7 +242,14 @@ void Controller::OnPlayerConnected(Player& player)
 
 void Controller::OnPlayerDisconnected(Player& player)
 {
-
+	LOCK(m_replayMutex);
+	auto it = m_replayBuffers.find(&player);
+	if (it != m_replayBuffers.end())
+	{
+		it->second.bConnected = false;
+		it->second.disconnected = std::chrono::steady_clock::now();
+	}
+	EvictReplayBuffers();
 }
 
 // Update everything. 
@@ -117,29 +281,26 @@ void Controller::SendUpdateGame(const Game& game, const Player* pPlayer) const
 		{
 			const Player& infoPlayer = pInfoTeam->GetPlayer();
 			VERIFY_MODEL_MSG("Team not chosen yet", !!pInfoTeam);
-			SendMessage(Output::UpdateTeam(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateInfluenceTrack(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateTechnologyTrack(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateStorageTrack(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdatePopulationTrack(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateActionTrack(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateColonyShips(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdatePassed(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateBlueprints(*pInfoTeam), game, pPlayer);
-			SendMessage(Output::UpdateVictoryPointTiles(*pInfoTeam), game, pPlayer);
-			
-			// Reputation tile values are secret, so only send them to the relevant player. 
-			if (pPlayer)
-				SendMessage(Output::UpdateReputationTrack(*pInfoTeam, pPlayer == &infoPlayer), game, pPlayer);
-			else
-				for (auto& dstPlayer : game.GetCurrentPlayers())
-					SendMessage(Output::UpdateReputationTrack(*pInfoTeam, dstPlayer == &infoPlayer), game, dstPlayer);
+			const Team& team = *pInfoTeam;
+			const std::string colour = ::EnumToString(team.GetColour());
+			SendSharedMessage<Output::UpdateTeam>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateInfluenceTrack>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateTechnologyTrack>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateStorageTrack>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdatePopulationTrack>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateActionTrack>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateColonyShips>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdatePassed>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateBlueprints>(game, colour, pPlayer, team);
+			SendSharedMessage<Output::UpdateVictoryPointTiles>(game, colour, pPlayer, team);
+			SendSecretMessage<Output::UpdateReputationTrack>(game, colour, infoPlayer, pPlayer, team); // Values only for the owner.
 		}
-		SendMessage(Output::UpdateMap(game), game, pPlayer);
-		SendMessage(Output::UpdateTechnologies(game), game, pPlayer);
-		SendMessage(Output::UpdateRound(game), game, pPlayer);
-		SendMessage(Output::AddLog(game.GetLogs()), game, pPlayer);
-		SendMessage(Output::UpdateCurrentPlayers(*pLive), *pLive, pPlayer);
+		SendSharedMessage<Output::UpdateMap>(game, "", pPlayer, game);
+		SendSharedMessage<Output::UpdateTechnologies>(game, "", pPlayer, game);
+		SendSharedMessage<Output::UpdateRound>(game, "", pPlayer, game);
+		SendMessage(game.GetLogCache().GetPayload(), game, pPlayer); // Pre-serialised.
+		if (pLive)
+			SendMessage(Output::UpdateCurrentPlayers(*pLive), *pLive, pPlayer);
 	}
 
 	bool isBattle = game.HasBattle();
@@ -1,15 +1,22 @@
 #pragma once
 
 #include "Input.h"
+#include "ReplayBuffer.h"
 
 #include "libKernel/Singleton.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <typeinfo>
 
 class WSServer;
 class Game;
+class LiveGame;
 
 namespace Output { class Message; }
 
@@ -21,22 +28,62 @@ public:
 	void SetServer(WSServer* p) { m_pServer = p; }
 
 	void OnMessage(const Input::MessagePtr& pMsg, Player& player);
-	void OnPlayerConnected(Player& player);
+	void OnPlayerConnected(Player& player, int epoch = 0, int lastSeq = 0); // Resumes from lastSeq if we can.
 	void OnPlayerDisconnected(Player& player);
 
+	typedef std::shared_ptr<std::string> StringPtr;
+
 	void SendMessage(const Output::Message& msg, const Player& player) const;
 	void SendMessage(const Output::Message& msg, const Game& game, const Player* pPlayer = nullptr) const;
+	void SendMessage(StringPtr msg, const Game& game, const Player* pPlayer = nullptr) const;
+
+	// Builds and serialises a T(args) at most once per flush for each game and subject, however many times it's sent. 
+	// Only for messages that depend on nothing but the game state and the subject (e.g. a team colour).
+	template <typename T, typename... Args>
+	void SendSharedMessage(const Game& game, const std::string& subject, const Player* pPlayer, const Args&... args) const
+	{
+		SendMessage(GetSharedMessage(game, typeid(T).name() + ('/' + subject), [&] { return T(args...).GetXML(); }), game, pPlayer);
+	}
+
+	// Hidden information (e.g. reputation tile values): the owner gets T(args..., true), everyone else T(args..., false).
+	// Like SendSharedMessage, each version is built at most once per flush, however many players get it. 
+	template <typename T, typename... Args>
+	void SendSecretMessage(const Game& game, const std::string& subject, const Player& owner, const Player* pPlayer, const Args&... args) const
+	{
+		SendSecretMessage(game, typeid(T).name() + ('/' + subject), owner, pPlayer, [&](bool bOwner) { return T(args..., bOwner).GetXML(); });
+	}
+
+	static void OnGameChanged(const Game& game); // Forgets its shared messages.
 	
-	void SendUpdateGameList(const Player* pPlayer = nullptr) const;
+	void SendUpdateGameList(const Player& player) const; // The whole list.
+	void SendUpdateGameListEntry(const LiveGame& game) const; // Just game's summary, to everyone. 
 	void SendUpdateGame(const Game& game, const Player* pPlayer = nullptr) const;
 
 private:
-	typedef std::shared_ptr<std::string> StringPtr;
+	typedef std::shared_ptr<ReplayBuffer> ReplayBufferPtr;
+
+	// A player's buffer outlives their connection by ReplayGraceSeconds, so a quick reconnect just gets what it missed.
+	struct ReplayEntry
+	{
+		ReplayBufferPtr pBuffer;
+		bool bConnected;
+		std::chrono::steady_clock::time_point disconnected;
+	};
 
 	void SendMessage(StringPtr msg, const Player& player) const;
+	StringPtr GetSharedMessage(const Game& game, const std::string& key, const std::function<std::string()>& build) const;
+	void SendSecretMessage(const Game& game, const std::string& key, const Player& owner, const Player* pPlayer, const std::function<std::string(bool)>& build) const;
 	void SendQueuedMessages();
 	void ClearQueuedMessages();
+	void SendFrame(const std::string& msgs, const std::string& binaryMsgs, const Player& player); // binaryMsgs: encoded, for binary clients.
+	bool ResendFrames(const Player& player, int lastSeq);
+	ReplayBufferPtr GetReplayBuffer(const Player& player) const; // Null if the player isn't connected and their buffer has gone.
+	void EvictReplayBuffers(); // Of players gone longer than ReplayGraceSeconds. Call with m_replayMutex locked.
 
 	WSServer* m_pServer;
-	mutable std::map<const Player*, std::vector<StringPtr>> m_messages;
+	const int m_epoch; // Frame numbers are only meaningful within one run of the server. 
+	std::map<const Player*, ReplayEntry> m_replayBuffers;
+	mutable std::mutex m_replayMutex; // Guards m_replayBuffers, not the buffers.
+
+	static const int ReplayGraceSeconds;
 };
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "Deflater.h"
+
+#ifdef USE_ZLIB
+#include "zlib.h"
+
+#include <cstring>
+
+struct Deflater::Stream
+{
+	z_stream z;
+};
+
+Deflater::Deflater() : m_pStream(new Stream)
+{
+	std::memset(&m_pStream->z, 0, sizeof m_pStream->z);
+	int result = ::deflateInit2(&m_pStream->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY); // Negative bits: raw.
+	VERIFY_MSG("deflateInit2", result == Z_OK);
+}
+
+Deflater::~Deflater()
+{
+	::deflateEnd(&m_pStream->z);
+}
+
+bool Deflater::IsAvailable()
+{
+	return true;
+}
+
+std::string Deflater::Compress(const std::string& data)
+{
+	z_stream& z = m_pStream->z;
+
+	std::string out;
+	out.resize(::deflateBound(&z, (uLong)data.size()) + 16);
+
+	z.next_in = (Bytef*)data.data();
+	z.avail_in = (uInt)data.size();
+	z.next_out = (Bytef*)&out[0];
+	z.avail_out = (uInt)out.size();
+
+	while (true)
+	{
+		int result = ::deflate(&z, Z_SYNC_FLUSH);
+		VERIFY_MSG("deflate", result == Z_OK || result == Z_BUF_ERROR);
+		if (z.avail_out) // All flushed.
+			break;
+
+		// deflateBound doesn't allow for the flush marker, so we might need a little more.
+		size_t used = out.size();
+		out.resize(used * 2);
+		z.next_out = (Bytef*)&out[used];
+		z.avail_out = (uInt)(out.size() - used);
+	}
+	out.resize(out.size() - z.avail_out);
+
+	VERIFY_MSG("deflate: no flush marker", out.size() >= 4 && out.compare(out.size() - 4, 4, "\0\0\xff\xff", 4) == 0);
+	out.resize(out.size() - 4);
+	return out;
+}
+
+std::string Deflater::Gzip(const std::string& data)
+{
+	z_stream z;
+	std::memset(&z, 0, sizeof z);
+	int result = ::deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY); // +16: gzip wrapper.
+	VERIFY_MSG("deflateInit2", result == Z_OK);
+
+	std::string out;
+	out.resize(::deflateBound(&z, (uLong)data.size()) + 32); // Room for the gzip header.
+
+	z.next_in = (Bytef*)data.data();
+	z.avail_in = (uInt)data.size();
+	z.next_out = (Bytef*)&out[0];
+	z.avail_out = (uInt)out.size();
+
+	result = ::deflate(&z, Z_FINISH);
+	out.resize(out.size() - z.avail_out);
+	::deflateEnd(&z);
+
+	VERIFY_MSG("deflate", result == Z_STREAM_END);
+	return out;
+}
+
+#else
+
+struct Deflater::Stream {};
+
+Deflater::Deflater()
+{
+	VERIFY_MSG("Deflater: built without USE_ZLIB", false);
+}
+
+Deflater::~Deflater()
+{
+}
+
+bool Deflater::IsAvailable()
+{
+	return false;
+}
+
+std::string Deflater::Compress(const std::string& data)
+{
+	return data;
+}
+
+std::string Deflater::Gzip(const std::string& data)
+{
+	return data;
+}
+
+#endif
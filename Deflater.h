@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// Raw deflate with the context kept from one message to the next, as in permessage-deflate (RFC 7692). 
+// Needs zlib: define USE_ZLIB to build it in. Without it IsAvailable is false, and messages and assets go uncompressed.
+class Deflater
+{
+public:
+	Deflater();
+	~Deflater();
+	Deflater(const Deflater&) = delete;
+	Deflater& operator=(const Deflater&) = delete;
+
+	static bool IsAvailable();
+
+	// Ends with a sync flush, minus its 00 00 ff ff tail, which the receiver adds back before inflating.
+	std::string Compress(const std::string& data);
+
+	static std::string Gzip(const std::string& data); // A whole gzip file, for HTTP.
+
+private:
+	struct Stream;
+	std::unique_ptr<Stream> m_pStream;
+};
@@ -74,7 +74,7 @@ private:
 		case DiscoveryClass::ShipPart: 
 			break;
 		case DiscoveryClass::Ship: 
-			context.SendMessage(Output::UpdateMap(game));
+			context.SendMapDelta();
 			break;
 		};
 	}
@@ -0,0 +1,279 @@
+#include "stdafx.h"
+#include "DurableFile.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	const std::string ChecksumPrefix = "\n<!-- crc32:";
+	const std::string ChecksumSuffix = " -->\n";
+	const size_t MaxGroupSize = 64;
+
+	using DurableFile::Item;
+
+	struct Group
+	{
+		Group() : bDone(false) {}
+		std::vector<Item*> items;
+		bool bDone;
+	};
+
+	std::mutex s_mutex;
+	std::condition_variable s_cv;
+	std::shared_ptr<Group> s_pOpenGroup; // Still taking items.
+	std::chrono::milliseconds s_window(10);
+
+	uint32_t GetCRC32(const std::string& data, size_t size)
+	{
+		static const auto table = []
+		{
+			std::vector<uint32_t> t(256);
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+					c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+				t[i] = c;
+			}
+			return t;
+		}();
+
+		uint32_t crc = 0xffffffff;
+		for (size_t i = 0; i < size; ++i)
+			crc = table[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+		return crc ^ 0xffffffff;
+	}
+
+	bool ReadFile(const fs::path& path, std::string& data)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !file.bad();
+	}
+
+	// An XML comment, so the file still loads as it is.
+	bool AppendChecksum(const fs::path& path)
+	{
+		std::string data;
+		if (!ReadFile(path, data))
+			return false;
+
+		char hex[9];
+		std::snprintf(hex, sizeof hex, "%08x", GetCRC32(data, data.size()));
+
+		std::ofstream file(path, std::ios::binary | std::ios::app);
+		file << ChecksumPrefix << hex << ChecksumSuffix;
+		file.close();
+		return !!file;
+	}
+
+	bool FlushFile(const fs::path& path, bool bDir)
+	{
+#ifdef _WIN32
+		if (bDir)
+			return true; // Renames are written through instead.
+
+		HANDLE hFile = ::CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+		bool bOK = ::FlushFileBuffers(hFile) != 0;
+		::CloseHandle(hFile);
+		return bOK;
+#else
+		int fd = ::open(path.c_str(), bDir ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+		if (fd < 0)
+			return false;
+		bool bOK = ::fsync(fd) == 0;
+		::close(fd);
+		return bOK;
+#endif
+	}
+
+	// Keeps the current file as <path>.prev, via a hard link so that path itself never goes missing.
+	bool ReplaceFile(const fs::path& tmpPath, const fs::path& path)
+	{
+		std::error_code error;
+		if (fs::exists(path, error))
+		{
+			fs::path prevPath = path;
+			prevPath += ".prev";
+			fs::remove(prevPath, error);
+			fs::create_hard_link(path, prevPath, error);
+			if (error)
+				fs::copy_file(path, prevPath, fs::copy_options::overwrite_existing, error);
+		}
+
+#ifdef _WIN32
+		return ::MoveFileExW(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		fs::rename(tmpPath, path, error);
+		return !error;
+#endif
+	}
+
+	enum class Check { OK, Unchecked, Corrupt };
+
+	Check CheckFile(const fs::path& path)
+	{
+		std::string data;
+		if (!ReadFile(path, data))
+			return Check::Corrupt;
+
+		size_t pos = data.rfind(ChecksumPrefix);
+		if (pos == std::string::npos)
+			return Check::Unchecked; // Saved before we had checksums, or cut short.
+
+		const size_t hexPos = pos + ChecksumPrefix.size();
+		if (data.size() != hexPos + 8 + ChecksumSuffix.size() || data.compare(hexPos + 8, std::string::npos, ChecksumSuffix) != 0)
+			return Check::Corrupt;
+
+		return std::strtoul(data.substr(hexPos, 8).c_str(), nullptr, 16) == GetCRC32(data, pos) ? Check::OK : Check::Corrupt;
+	}
+
+	void Flush(Group& group)
+	{
+		std::set<fs::path> dirs;
+		for (Item* item : group.items)
+		{
+			item->bOK = FlushFile(item->tmpPath.empty() ? item->path : item->tmpPath, false);
+			if (item->bOK && !item->tmpPath.empty())
+			{
+				item->bOK = ReplaceFile(item->tmpPath, item->path);
+				dirs.insert(item->path.parent_path());
+			}
+		}
+
+		// Makes the renames durable.
+		for (auto& dir : dirs)
+			FlushFile(dir.empty() ? fs::path(".") : dir, true);
+	}
+
+	// The first caller in a group waits for the window (or a full group), then flushes everyone's.
+	void CommitGroup(Item* items, size_t count)
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+
+		std::shared_ptr<Group> pGroup = s_pOpenGroup;
+		const bool bLeader = !pGroup;
+		if (bLeader)
+			s_pOpenGroup = pGroup = std::make_shared<Group>();
+		for (size_t i = 0; i < count; ++i)
+			pGroup->items.push_back(&items[i]);
+
+		if (bLeader)
+		{
+			s_cv.wait_for(lock, s_window, [&] { return pGroup->items.size() >= MaxGroupSize; });
+			s_pOpenGroup = nullptr; // Later items start the next group.
+
+			lock.unlock();
+			Flush(*pGroup);
+			lock.lock();
+
+			pGroup->bDone = true;
+			s_cv.notify_all();
+		}
+		else
+		{
+			if (pGroup->items.size() >= MaxGroupSize)
+				s_cv.notify_all();
+			s_cv.wait(lock, [&] { return pGroup->bDone; });
+		}
+	}
+}
+
+void DurableFile::SetWindow(std::chrono::milliseconds window)
+{
+	LOCK(s_mutex);
+	s_window = window;
+}
+
+bool DurableFile::Prepare(const fs::path& path, const WriteFunc& write, Item& item)
+{
+	fs::path tmpPath = path;
+	tmpPath += ".tmp";
+
+	if (!write(tmpPath) || !AppendChecksum(tmpPath))
+		return false;
+
+	item = Item{ path, tmpPath, false };
+	return true;
+}
+
+DurableFile::Item DurableFile::PrepareSync(const fs::path& path)
+{
+	return Item{ path, fs::path(), false };
+}
+
+bool DurableFile::Commit(std::vector<Item>& items)
+{
+	if (items.empty())
+		return true;
+
+	CommitGroup(items.data(), items.size());
+	return std::all_of(items.begin(), items.end(), [](const Item& item) { return item.bOK; });
+}
+
+bool DurableFile::Save(const fs::path& path, const WriteFunc& write)
+{
+	Item item;
+	if (!Prepare(path, write, item))
+		return false;
+
+	CommitGroup(&item, 1);
+	return item.bOK;
+}
+
+bool DurableFile::Sync(const fs::path& path)
+{
+	Item item = PrepareSync(path);
+	CommitGroup(&item, 1);
+	return item.bOK;
+}
+
+bool DurableFile::Verify(const fs::path& path)
+{
+	return CheckFile(path) != Check::Corrupt;
+}
+
+// A file without a checksum is only trusted if its previous generation doesn't have one either:
+// otherwise it's a new file that was cut short.
+fs::path DurableFile::GetLoadPath(const fs::path& path)
+{
+	fs::path prevPath = path;
+	prevPath += ".prev";
+
+	const Check check = CheckFile(path);
+	if (check == Check::OK)
+		return path;
+
+	const Check prevCheck = CheckFile(prevPath);
+	if (check == Check::Unchecked && prevCheck != Check::OK)
+		return path;
+
+	if (prevCheck == Check::Corrupt)
+	{
+		std::cerr << "WARNING: " << path.string() << " is corrupt, and so is its previous save" << std::endl;
+		return path;
+	}
+
+	std::cerr << "WARNING: " << path.string() << " is corrupt, loading the previous save" << std::endl;
+	return prevPath;
+}
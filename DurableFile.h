@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+// Crash-safe saving. A file is written to <path>.tmp with a checksum on the end, flushed to disk and renamed over <path>, 
+// and the file it replaces is kept as <path>.prev. So <path> is always a complete file, and a corrupt one can be detected.
+// Flushes are group-committed: the first save waits up to the window for others to join it, then flushes them all,  
+// so a busy server pays for one round of disk flushes per window rather than one per save.
+namespace DurableFile
+{
+	typedef std::function<bool(const std::filesystem::path& tmpPath)> WriteFunc;
+
+	// A write that isn't on disk until it's committed.
+	struct Item
+	{
+		std::filesystem::path path, tmpPath; // No tmpPath: just flush path.
+		bool bOK;
+	};
+
+	void SetWindow(std::chrono::milliseconds window);
+
+	bool Prepare(const std::filesystem::path& path, const WriteFunc& write, Item& item); // Writes <path>.tmp, to replace path.
+	Item PrepareSync(const std::filesystem::path& path); // After appending to path.
+	bool Commit(std::vector<Item>& items); // In one group. Returns once they're on disk: false if any failed (see bOK).
+
+	bool Save(const std::filesystem::path& path, const WriteFunc& write); // Prepare and commit.
+	bool Sync(const std::filesystem::path& path); // After appending to path. Returns once it's on disk.
+
+	bool Verify(const std::filesystem::path& path); // False if it's missing or its checksum doesn't match. Files without one pass.
+	std::filesystem::path GetLoadPath(const std::filesystem::path& path); // path, or <path>.prev if path is corrupt.
+}
@@ -67,8 +67,7 @@ std::vector<MapPos> ExploreCmd::GetPositions(const LiveGame& game) const
 	VERIFY_INPUT(!team.HasPassed());
 
 	std::set<MapPos> positions;
-	const Map::HexMap& hexes = game.GetMap().GetHexes();
-	for (auto& h : hexes)
+	for (auto h : game.GetMap().GetHexes())
 		if (h.second->CanExploreFrom(team))
 			game.GetMap().GetEmptyNeighbours(h.first, team.HasTech(TechType::WormholeGen), positions);
 
@@ -164,7 +163,7 @@ public:
 		if (m_bInfluence)
 			context.SendMessage(Output::UpdateInfluenceTrack(team));
 
-		context.SendMessage(Output::UpdateMap(context.GetGame()));
+		context.SendMapDelta();
 	}
 
 	virtual void Save(Serial::SaveNode& node) const override 
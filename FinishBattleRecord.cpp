@@ -22,7 +22,7 @@ void FinishBattleRecord::Apply(bool bDo, const Game& game, GameState& gameState)
 
 void FinishBattleRecord::Update(const Game& game, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateShowCombat(game, game.HasBattle()));
+	context.SendSharedMessage<Output::UpdateShowCombat>("", game, game.HasBattle());
 }
 
 std::string FinishBattleRecord::GetMessage(const Game& game) const
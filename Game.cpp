@@ -26,11 +26,9 @@ Game::Game(int id, const std::string& name, const Player& owner, const Game& rhs
 	 m_techBag(rhs.m_techBag), m_discBag(rhs.m_discBag)
 {
 	for (auto& t : rhs.m_teams)
-	{
-		auto& teamState = m_state.GetTeamState(t->GetColour());
 		m_teams.push_back(TeamPtr(new Team(*t)));
-		m_teams.back()->SetState(teamState);
-	}
+
+	m_state.AttachTeams(*this);
 }
 
 Game::~Game()
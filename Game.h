@@ -14,6 +14,7 @@
 
 class CmdStack;
 class Record;
+class LogCache;
 
 
 
@@ -45,7 +46,7 @@ public:
 
 	virtual bool HasStarted() const = 0;
 	virtual bool IsLive() const { return false; }
-	virtual std::vector<std::pair<int, std::string>> GetLogs() const = 0;
+	virtual const LogCache& GetLogCache() const = 0;
 
 	const ReputationBag& GetReputationBag() const { return const_cast<GameState&>(m_state).GetReputationBag(); }
 	const TechnologyBag& GetTechnologyBag() const { return m_techBag; }
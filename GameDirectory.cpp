@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "GameDirectory.h"
+#include "Games.h"
+#include "LiveGame.h"
+#include "Player.h"
+#include "Team.h"
+#include "JsonWriter.h"
+
+std::mutex GameDirectory::s_mutex;
+std::unordered_map<int, GameDirectory::EntryPtr> GameDirectory::s_entries;
+std::vector<int> GameDirectory::s_order;
+
+bool GameDirectory::Entry::IsMine(const Player& player) const
+{
+	return players.count(player.GetID()) > 0;
+}
+
+void GameDirectory::Build()
+{
+	for (auto& pGame : Games::GetLiveGames())
+		Update(*pGame);
+}
+
+GameDirectory::EntryPtr GameDirectory::Update(const LiveGame& game)
+{
+	EntryPtr pEntry = CreateEntry(game);
+
+	LOCK(s_mutex);
+	EntryPtr& pOld = s_entries[game.GetID()];
+	if (!pOld)
+		s_order.push_back(game.GetID());
+	pOld = pEntry;
+	return pEntry;
+}
+
+std::vector<GameDirectory::EntryPtr> GameDirectory::GetEntries()
+{
+	LOCK(s_mutex);
+	std::vector<EntryPtr> entries;
+	entries.reserve(s_order.size());
+	for (int id : s_order)
+		entries.push_back(s_entries[id]);
+	return entries;
+}
+
+GameDirectory::EntryPtr GameDirectory::CreateEntry(const LiveGame& game)
+{
+	auto pEntry = std::make_shared<Entry>();
+	pEntry->bStarted = game.HasStarted();
+
+	JsonWriter writer;
+	auto root = writer.GetDocument();
+	root.SetAttribute("name", game.GetName());
+	root.SetAttribute("id", game.GetID());
+	root.SetAttribute("owner", game.GetOwner().GetName());
+
+	auto playersNode = root.AddArray("players");
+	for (auto& team : game.GetTeams())
+	{
+		playersNode.Append(team->GetPlayer().GetName());
+		pEntry->players.insert(team->GetPlayer().GetID());
+	}
+
+	pEntry->json = writer.GetString();
+	return pEntry;
+}
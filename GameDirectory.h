@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class LiveGame;
+class Player;
+
+// A summary of each live game for the game list, serialised once whenever the game changes. 
+// Each player's list is then just the summaries sorted into groups, and a change to one game only needs its summary sent. 
+// Summaries stay when their games are hibernated, so listing games never loads them.
+class GameDirectory
+{
+public:
+	struct Entry
+	{
+		std::string json; // {name, id, owner, players}
+		std::set<int> players; // IDs of players who've joined.
+		bool bStarted;
+
+		bool IsMine(const Player& player) const;
+		const char* GetGroup(const Player& player) const { return GetGroup(IsMine(player)); }
+		const char* GetGroup(bool bMine) const { return bMine ? "mine" : bStarted ? "other" : "open"; }
+	};
+	typedef std::shared_ptr<const Entry> EntryPtr;
+
+	static void Build(); // From Games::GetLiveGames, after loading. 
+	static EntryPtr Update(const LiveGame& game); // When a game is created, joined, unjoined or started.
+	static std::vector<EntryPtr> GetEntries(); // In the order they were added.
+
+private:
+	static EntryPtr CreateEntry(const LiveGame& game);
+
+	static std::mutex s_mutex;
+	static std::unordered_map<int, EntryPtr> s_entries; // By game ID.
+	static std::vector<int> s_order;
+};
@@ -0,0 +1,314 @@
+#include "stdafx.h"
+#include "GameJournal.h"
+#include "LiveGame.h"
+#include "Record.h"
+
+#include "libKernel/Xml.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+// File layout:
+//   header: "EJNL", varint version, varint snapshot ID
+//   blocks: varint length, then entries
+//   entry:  type byte, varint length, payload
+// A Push payload is the serialised record, a Pop payload is the varint record ID and a Progress payload is the
+// serialised phase, written at the end of every block.
+
+namespace
+{
+	const std::string Magic = "EJNL";
+	const unsigned int Version = 1;
+
+	void WriteVarint(std::string& buf, unsigned int val)
+	{
+		while (val >= 0x80)
+		{
+			buf.push_back(char(val & 0x7f | 0x80));
+			val >>= 7;
+		}
+		buf.push_back(char(val));
+	}
+
+	bool ReadVarint(const std::string& buf, size_t& pos, unsigned int& val)
+	{
+		val = 0;
+		for (int shift = 0; pos < buf.size() && shift < 35; shift += 7)
+		{
+			unsigned char c = buf[pos++];
+			val |= (c & 0x7f) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	void WriteBytes(std::string& buf, const std::string& bytes)
+	{
+		WriteVarint(buf, (unsigned int)bytes.size());
+		buf += bytes;
+	}
+
+	bool ReadBytes(const std::string& buf, size_t& pos, std::string& bytes)
+	{
+		unsigned int size = 0;
+		if (!ReadVarint(buf, pos, size) || size > buf.size() - pos)
+			return false;
+
+		bytes = buf.substr(pos, size);
+		pos += size;
+		return true;
+	}
+
+	template <typename T>
+	std::string SaveToString(const T& obj)
+	{
+		Xml::Document doc;
+		Serial::SaveNode node(doc.AddElement("journal"));
+		obj.Save(node);
+		return doc.SaveToString();
+	}
+
+	template <typename T>
+	bool LoadFromString(const std::string& str, T& obj)
+	{
+		Xml::Document doc;
+		if (!doc.LoadFromString(str))
+			return false;
+
+		obj.Load(Serial::LoadNode(doc.GetRoot()));
+		return true;
+	}
+
+	struct RecordSaver
+	{
+		RecordSaver(const RecordPtr& pRec) : m_pRec(pRec) {}
+		void Save(Serial::SaveNode& node) const { node.SaveObject("record", m_pRec); }
+		const RecordPtr& m_pRec;
+	};
+
+	struct RecordLoader
+	{
+		void Load(const Serial::LoadNode& node) { node.LoadObject("record", m_pRec); }
+		RecordPtr m_pRec;
+	};
+
+	struct ProgressSaver
+	{
+		ProgressSaver(const LiveGame& game) : m_game(game) {}
+		void Save(Serial::SaveNode& node) const { m_game.SaveProgress(node); }
+		const LiveGame& m_game;
+	};
+
+	struct ProgressLoader
+	{
+		ProgressLoader(LiveGame& game) : m_game(game) {}
+		void Load(const Serial::LoadNode& node) { m_game.LoadProgress(node); }
+		LiveGame& m_game;
+	};
+}
+
+GameJournal::GameJournal() : m_nWritten(0)
+{
+}
+
+void GameJournal::AddPush(int idRecord)
+{
+	m_entries.push_back(Entry{ EntryType::Push, idRecord });
+}
+
+void GameJournal::AddPop(int idRecord)
+{
+	// A record that was pushed and popped between saves never needs writing.
+	for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+		if (it->type == EntryType::Push && it->idRecord == idRecord)
+		{
+			m_entries.erase(std::next(it).base());
+			return;
+		}
+
+	m_entries.push_back(Entry{ EntryType::Pop, idRecord });
+}
+
+bool GameJournal::Reset(const std::string& path, int idSnapshot)
+{
+	m_nWritten = 0;
+
+	std::string header = Magic;
+	WriteVarint(header, Version);
+	WriteVarint(header, idSnapshot);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(header.data(), header.size());
+	file.flush();
+	return !!file;
+}
+
+bool GameJournal::Append(const std::string& path, const LiveGame& game)
+{
+	std::string block;
+	for (auto& entry : m_entries)
+	{
+		std::string payload;
+		if (entry.type == EntryType::Push)
+		{
+			auto it = std::find_if(game.m_records.rbegin(), game.m_records.rend(), [&](const RecordPtr& r) { return r->GetID() == entry.idRecord; });
+			VERIFY_SERIAL_MSG("journal record not found", it != game.m_records.rend());
+			payload = SaveToString(RecordSaver(*it));
+		}
+		else
+			WriteVarint(payload, entry.idRecord);
+
+		block.push_back(char(entry.type));
+		WriteBytes(block, payload);
+	}
+
+	block.push_back(char(EntryType::Progress));
+	WriteBytes(block, SaveToString(ProgressSaver(game)));
+
+	std::string frame;
+	WriteBytes(frame, block);
+
+	std::ofstream file(path, std::ios::binary | std::ios::app);
+	file.write(frame.data(), frame.size());
+	file.close();
+	if (!file)
+		return false;
+
+	m_nWritten += (int)m_entries.size();
+	m_entries.clear();
+	return true;
+}
+
+bool GameJournal::Replay(const std::string& path, int idSnapshot, LiveGame& game)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	const std::string buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	size_t pos = Magic.size();
+	unsigned int version = 0, idJournalSnapshot = 0;
+	if (buf.compare(0, Magic.size(), Magic) != 0 || !ReadVarint(buf, pos, version) || !ReadVarint(buf, pos, idJournalSnapshot))
+	{
+		std::cerr << "WARNING: Ignoring invalid journal: " << path << std::endl;
+		return false;
+	}
+
+	if (version != Version || (int)idJournalSnapshot != idSnapshot)
+	{
+		std::cout << "INFO: Ignoring stale journal: " << path << std::endl;
+		return false;
+	}
+
+	// Corrupt entries are treated like a torn tail: replay stops at the last good block and the rest is dropped.
+	// Each block is decoded before any of it is applied, so a bad entry never leaves a block half done.
+	struct Op
+	{
+		EntryType type;
+		RecordPtr pRec;
+		unsigned int idRecord;
+		std::string progress;
+	};
+
+	auto decodeBlock = [](const std::string& block, std::vector<Op>& ops)
+	{
+		size_t blockPos = 0;
+		while (blockPos < block.size())
+		{
+			Op op{ EntryType(block[blockPos++]), nullptr, 0 };
+			std::string payload;
+			if (!ReadBytes(block, blockPos, payload))
+				return false;
+
+			size_t payloadPos = 0;
+			RecordLoader loader;
+			Xml::Document doc;
+			switch (op.type)
+			{
+			case EntryType::Push:
+				if (!LoadFromString(payload, loader) || !loader.m_pRec)
+					return false;
+				op.pRec = std::move(loader.m_pRec);
+				break;
+			case EntryType::Pop:
+				if (!ReadVarint(payload, payloadPos, op.idRecord))
+					return false;
+				break;
+			case EntryType::Progress:
+				if (!doc.LoadFromString(payload))
+					return false;
+				op.progress = std::move(payload);
+				break;
+			default:
+				return false;
+			}
+			ops.push_back(std::move(op));
+		}
+		return true;
+	};
+
+	int nBlocks = 0;
+	size_t validSize = pos;
+	bool bCorrupt = false;
+	std::string block;
+	while (!bCorrupt && ReadBytes(buf, pos, block))
+	{
+		std::vector<Op> ops;
+		try
+		{
+			bCorrupt = !decodeBlock(block, ops);
+			for (size_t i = 0; i < ops.size() && !bCorrupt; ++i)
+			{
+				Op& op = ops[i];
+				if (op.type == EntryType::Push)
+					game.ReplayPushRecord(std::move(op.pRec));
+				else if (op.type == EntryType::Pop)
+					game.ReplayPopRecord(op.idRecord);
+				else
+				{
+					ProgressLoader loader(game);
+					bCorrupt = !LoadFromString(op.progress, loader);
+				}
+				if (op.type != EntryType::Progress)
+					++m_nWritten;
+			}
+		}
+		catch (Exception& e)
+		{
+			std::cerr << "WARNING: " << e.what() << std::endl;
+			bCorrupt = true;
+		}
+
+		if (!bCorrupt)
+		{
+			validSize = pos;
+			++nBlocks;
+		}
+	}
+
+	if (bCorrupt)
+		std::cerr << "WARNING: Stopping at corrupt journal block " << nBlocks << ": " << path << std::endl;
+
+	if (validSize != buf.size())
+	{
+		// Torn write or corrupt block: drop the rest so later appends follow the last good block.
+		std::cerr << "WARNING: Discarding " << buf.size() - validSize << " bytes of journal: " << path << std::endl;
+		std::error_code error;
+		std::filesystem::resize_file(path, validSize, error);
+		if (error)
+			return false;
+	}
+
+	if (nBlocks)
+		std::cout << "INFO: Replayed " << nBlocks << " journal blocks: " << path << std::endl;
+
+	// A block that failed while being applied may have left the game part way through it, so take a snapshot.
+	return !bCorrupt;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class LiveGame;
+
+// Append-only log of the records pushed and popped since a LiveGame was last saved in full.
+// Each save appends one length-prefixed block, so the cost scales with the delta rather than with the game length.
+// The journal header holds the snapshot ID it extends; a journal that doesn't match the loaded snapshot is ignored.
+class GameJournal
+{
+public:
+	GameJournal();
+
+	void AddPush(int idRecord);
+	void AddPop(int idRecord);
+	void Clear() { m_entries.clear(); }
+
+	int GetWrittenCount() const { return m_nWritten; }
+
+	bool Reset(const std::string& path, int idSnapshot); // Truncates the file. Entries not yet written are kept: they follow the snapshot.
+	bool Append(const std::string& path, const LiveGame& game); // Not on disk until the file's synced.
+
+	// Returns false if the journal is missing or can't be appended to, in which case a snapshot is needed.
+	bool Replay(const std::string& path, int idSnapshot, LiveGame& game);
+
+private:
+	enum class EntryType : unsigned char { None, Push, Pop, Progress };
+
+	struct Entry
+	{
+		EntryType type;
+		int idRecord;
+	};
+
+	std::vector<Entry> m_entries; // Not yet written.
+	int m_nWritten; // Entries in the file.
+};
@@ -6,8 +6,9 @@
 #include "Team.h"
 #include "TeamState.h"
 #include "Game.h"
+#include "StateHash.h"
 
-GameState::GameState(Game& game) : m_map(game), m_iRound(-1)
+GameState::GameState(Game& game) : m_map(game), m_iRound(-1), m_game(game)
 {
 	InitBags(game);
 }
@@ -15,16 +16,38 @@ GameState::GameState(Game& game) : m_map(game), m_iRound(-1)
 GameState::GameState(const GameState& rhs, Game& game) :
 m_map(rhs.m_map, game), m_techs(rhs.m_techs), m_iRound(rhs.m_iRound),
 m_battle(rhs.m_battle ? rhs.m_battle->Clone() : nullptr),
-m_repBag(rhs.m_repBag), m_techBagState(rhs.m_techBagState), m_discBagState(rhs.m_discBagState), m_hexPiles(rhs.m_hexPiles), m_hexDiscardPiles(rhs.m_hexDiscardPiles)
+m_repBag(rhs.m_repBag), m_techBagState(rhs.m_techBagState), m_discBagState(rhs.m_discBagState), m_hexPiles(rhs.m_hexPiles), m_hexDiscardPiles(rhs.m_hexDiscardPiles),
+m_teamStates(rhs.m_teamStates), m_game(game)
 {
 	InitBags(game);
-
-	for (auto& pair : rhs.m_teamStates)
-		m_teamStates.insert(std::make_pair(pair.first, TeamStatePtr(new TeamState(*pair.second))));
 }
 
 GameState::~GameState() {}
 
+void GameState::Restore(const GameState& rhs)
+{
+	m_map.Restore(rhs.m_map);
+	m_techs = rhs.m_techs;
+	m_iRound = rhs.m_iRound;
+	m_battle = rhs.m_battle ? rhs.m_battle->Clone() : nullptr;
+	m_repBag = rhs.m_repBag;
+	m_techBagState = rhs.m_techBagState;
+	m_discBagState = rhs.m_discBagState;
+	m_hexPiles = rhs.m_hexPiles;
+	m_hexDiscardPiles = rhs.m_hexDiscardPiles;
+	InitBags(m_game);
+
+	VERIFY_MODEL(m_teamStates.size() == rhs.m_teamStates.size());
+	for (auto& pair : rhs.m_teamStates)
+	{
+		auto i = m_teamStates.find(pair.first);
+		VERIFY_MODEL(i != m_teamStates.end());
+		TeamStatePtr old = i->second;
+		i->second = pair.second;
+		m_game.GetTeam(pair.first).ReplaceState(*old, *i->second);
+	}
+}
+
 bool GameState::operator==(const GameState& rhs) const
 {
 	if (!ArePtrMapsEqual(m_teamStates, rhs.m_teamStates))
@@ -39,6 +62,19 @@ bool GameState::operator==(const GameState& rhs) const
 	return false;
 }
 
+// The map hash is maintained incrementally. The rest is small enough to hash on demand.
+uint64_t GameState::GetHash() const
+{
+	StateHash hash(m_map.GetHash());
+	hash.AddRange(m_techs).Add(m_iRound);
+
+	for (auto& pair : m_teamStates)
+		hash.Add(pair.first).Add(pair.second->GetHash());
+
+	hash.Add(m_battle ? m_battle->GetHash() : 0);
+	return hash.Get();
+}
+
 void GameState::InitBags(const Game& game)
 {
 	m_techBagState.SetBag(game.GetTechnologyBag());
@@ -69,12 +105,37 @@ void GameState::Init(const Game& game)
 }
 
 TeamState& GameState::GetTeamState(Colour c)
+{
+	auto i = m_teamStates.find(c);
+	VERIFY_MODEL(i != m_teamStates.end());
+
+	if (i->second.use_count() > 1)
+	{
+		TeamStatePtr old = i->second;
+		i->second = std::make_shared<TeamState>(*old);
+		m_game.GetTeam(c).ReplaceState(*old, *i->second);
+	}
+	return *i->second;
+}
+
+const TeamState& GameState::GetTeamState(Colour c) const
 {
 	auto i = m_teamStates.find(c);
 	VERIFY_MODEL(i != m_teamStates.end());
 	return *i->second;
 }
 
+// Points the teams at our states without unsharing them.
+void GameState::AttachTeams(Game& game)
+{
+	for (auto& team : game.GetTeams())
+	{
+		auto i = m_teamStates.find(team->GetColour());
+		VERIFY_MODEL(i != m_teamStates.end());
+		team->SetState(*i->second);
+	}
+}
+
 bool GameState::IncrementRound(bool bDo)
 {
 	m_iRound += bDo ? 1 : -1;
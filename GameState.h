@@ -12,7 +12,7 @@ class ShipBattle;
 class PopulationBattle;
 
 DEFINE_UNIQUE_PTR(Battle)
-DEFINE_UNIQUE_PTR(TeamState)
+typedef std::shared_ptr<TeamState> TeamStatePtr; // Shared between copies until written to.
 
 class GameState
 {
@@ -20,13 +20,16 @@ public:
 	GameState(Game& game);
 	~GameState();
 	GameState(const GameState& rhs) = delete;
-	GameState(const GameState& rhs, Game& game);
+	GameState(const GameState& rhs, Game& game); // Shares hexes, team states and blueprints with rhs.
+	void Restore(const GameState& rhs); // Like the copy constructor, but keeps our game and repoints its teams.
 	bool operator==(const GameState& rhs) const;
+	uint64_t GetHash() const; // Cheap alternative to operator==.
 
 	void Init(const Game& game);
 
-	TeamState& GetTeamState(Colour c);
-	const TeamState& GetTeamState(Colour c) const { return const_cast<GameState*>(this)->GetTeamState(c); }
+	TeamState& GetTeamState(Colour c); // Unshares the team state.
+	const TeamState& GetTeamState(Colour c) const;
+	void AttachTeams(Game& game);
 
 	std::map<TechType, int>& GetTechnologies() { return m_techs; }
 	Map& GetMap() { return m_map; }
@@ -60,6 +63,8 @@ public:
 
 private:
 	void InitBags(const Game& game);
+
+	Game& m_game;
 		
 	ReputationBag m_repBag;
 	BagState<TechnologyBag> m_techBagState;
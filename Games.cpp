@@ -2,98 +2,167 @@
 #include "Games.h"
 #include "LiveGame.h"
 #include "ReviewGame.h"
+#include "WorkerPool.h"
+#include "Players.h"
+#include "SaveThread.h"
+#include "DurableFile.h"
 
 #include "libKernel/Filesystem.h"
 #include "libKernel/Xml.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+
 int Games::s_nNextGameID = 1;
 int Games::s_nNextTestGameID = -1;
 std::vector<LiveGamePtr> Games::s_liveGames;
 std::vector<ReviewGamePtr> Games::s_reviewGames;
+std::unordered_map<int, LiveGame*> Games::s_liveIndex;
+std::unordered_map<int, ReviewGame*> Games::s_reviewIndex;
+std::set<int> Games::s_hibernated;
+std::recursive_mutex Games::s_mutex;
+
+namespace
+{
+	std::wstring GetLiveGamePath()
+	{
+		return L"data/games/live/";
+	}
+}
 
 void Games::Load()
 {
 	VERIFY_SERIAL(s_liveGames.empty() && s_reviewGames.empty());
 	
-	std::wstring dir = L"data/games/live/";
+	std::wstring dir = GetLiveGamePath();
 	auto files = Kernel::FileSystem::FindFilesInDir(dir, L"*.xml");
-	
-	for (auto& f : files)
+
+	// One task per game. Each task only touches its own slot.
+	std::vector<LiveGamePtr> games(files.size());
+	std::vector<double> times(files.size());
+	std::vector<uintmax_t> sizes(files.size());
+
+	auto start = std::chrono::steady_clock::now();
 	{
-		LiveGamePtr pGame(new LiveGame);
-		if (Serial::LoadClass(dir + f, *pGame))
-		{
-			s_nNextGameID = std::max(s_nNextGameID, pGame->GetID() + 1);
+		WorkerPool pool;
+		for (size_t i = 0; i < files.size(); ++i)
+			pool.Push([&, i]
+			{
+				auto gameStart = std::chrono::steady_clock::now();
+				LiveGamePtr pGame(new LiveGame);
+				auto path = DurableFile::GetLoadPath(dir + files[i]);
+				std::error_code error;
+				auto size = std::filesystem::file_size(path, error);
+				sizes[i] = error ? 0 : size;
+				if (Serial::LoadClass(path.wstring(), *pGame))
+				{
+					pGame->LoadJournal();
+					games[i] = std::move(pGame);
+				}
+				times[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gameStart).count();
+			});
+
+		pool.Wait();
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Merge in ID order so the result doesn't depend on scheduling.
+	for (auto& pGame : games)
+		if (pGame)
 			s_liveGames.push_back(std::move(pGame));
-		}
 		else
 			ASSERT(false);
-	}
+
+	std::sort(s_liveGames.begin(), s_liveGames.end(), [](const LiveGamePtr& a, const LiveGamePtr& b) { return a->GetID() < b->GetID(); });
+	for (auto& pGame : s_liveGames)
+		ASSERT(s_liveIndex.insert(std::make_pair(pGame->GetID(), pGame.get())).second);
+
+	if (!s_liveGames.empty())
+		s_nNextGameID = std::max(s_nNextGameID, s_liveGames.back()->GetID() + 1);
+
+	uintmax_t bytes = std::accumulate(sizes.begin(), sizes.end(), uintmax_t(0));
+	double maxMS = times.empty() ? 0 : *std::max_element(times.begin(), times.end());
+	std::cout << "INFO: Loaded " << s_liveGames.size() << " of " << files.size() << " games (" << bytes << " bytes) in " << (int)ms << " ms, " 
+		<< (files.empty() ? 0 : (int)(std::accumulate(times.begin(), times.end(), 0.0) / files.size())) << " ms per game, slowest " << (int)maxMS << " ms" << std::endl;
 }
 
 LiveGame& Games::Add(const std::string& name, Player& owner)
 {
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
 	s_liveGames.push_back(LiveGamePtr(new LiveGame(s_nNextGameID++, name, owner)));
+	s_liveIndex[s_liveGames.back()->GetID()] = s_liveGames.back().get();
 	return *s_liveGames.back().get();
 }
 
 LiveGame& Games::AddTest(Player& owner)
 {
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
 	s_liveGames.push_back(LiveGamePtr(new LiveGame(s_nNextTestGameID, ::FormatString("Test %0", -s_nNextTestGameID), owner)));
 	--s_nNextTestGameID;
+	s_liveIndex[s_liveGames.back()->GetID()] = s_liveGames.back().get();
 	return *s_liveGames.back().get();
 }
 
 ReviewGame& Games::AddReview(Player& owner, const LiveGame& live)
 {
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
 	s_reviewGames.push_back(ReviewGamePtr(new ReviewGame(s_nNextGameID++, owner, live)));
+	s_reviewIndex[s_reviewGames.back()->GetID()] = s_reviewGames.back().get();
 	live.AddReviewGame(*s_reviewGames.back());
 	return *s_reviewGames.back();
 }
 
 void Games::DeleteReview(int idGame)
 {
-	for (auto i = s_reviewGames.begin(); i != s_reviewGames.end(); ++i)
-		if ((*i)->GetID() == idGame)
-		{
-			GetLive((*i)->GetLiveGameID()).RemoveReviewGame(**i);
-			s_reviewGames.erase(i);
-			return;
-		}
-	VERIFY_MODEL(false);
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	auto it = s_reviewIndex.find(idGame);
+	VERIFY_MODEL(it != s_reviewIndex.end());
+
+	ReviewGame* pGame = it->second;
+	GetLive(pGame->GetLiveGameID()).RemoveReviewGame(*pGame);
+	s_reviewIndex.erase(it);
+
+	// Keeps the order, and there are only ever a few review games.
+	s_reviewGames.erase(std::find_if(s_reviewGames.begin(), s_reviewGames.end(), [&](const ReviewGamePtr& p) { return p.get() == pGame; }));
 }
 
 const LiveGame& Games::GetLive(int idGame)
 {
-	for (auto& g : s_liveGames)
-		if (g->GetID() == idGame)
-			return *g;
-
-	VERIFY_MODEL(false);
-	return *(LiveGame*)nullptr;
+	{
+		std::lock_guard<std::recursive_mutex> lock(s_mutex);
+		auto it = s_liveIndex.find(idGame);
+		if (it != s_liveIndex.end())
+			return *it->second;
+	}
+	return Wake(idGame);
 }
 
 const ReviewGame& Games::GetReview(int idGame)
 {
-	for (auto& g : s_reviewGames)
-		if (g->GetID() == idGame)
-			return *g;
-
-	VERIFY_MODEL(false);
-	return *(ReviewGame*)nullptr;
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	auto it = s_reviewIndex.find(idGame);
+	VERIFY_MODEL(it != s_reviewIndex.end());
+	return *it->second;
 }
 
 const Game& Games::Get(int idGame)
 {
-	for (auto& g : s_liveGames)
-		if (g->GetID() == idGame)
-			return *g;
-	for (auto& g : s_reviewGames)
-		if (g->GetID() == idGame)
-			return *g;
+	{
+		std::lock_guard<std::recursive_mutex> lock(s_mutex);
+		auto live = s_liveIndex.find(idGame);
+		if (live != s_liveIndex.end())
+			return *live->second;
 
-	VERIFY_MODEL(false);
-	return *(Game*)nullptr;
+		if (!s_hibernated.count(idGame))
+		{
+			auto review = s_reviewIndex.find(idGame);
+			VERIFY_MODEL(review != s_reviewIndex.end());
+			return *review->second;
+		}
+	}
+	return Wake(idGame);
 }
 
 bool Games::IsGame(int idGame)
@@ -103,18 +172,95 @@ bool Games::IsGame(int idGame)
 
 bool Games::IsLiveGame(int idGame)
 {
-	if (idGame)
-		for (auto& g : s_liveGames)
-			if (g->GetID() == idGame)
-				return true;
-	return false;
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	return idGame && (s_liveIndex.count(idGame) || s_hibernated.count(idGame));
 }
 
 bool Games::IsReviewGame(int idGame)
 {
-	if (idGame)
-		for (auto& g : s_reviewGames)
-			if (g->GetID() == idGame)
-				return true;
-	return false;
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	return idGame && s_reviewIndex.count(idGame);
+}
+
+int Games::GetLiveGameCount()
+{
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	return int(s_liveIndex.size() + s_hibernated.size());
+}
+
+void Games::Hibernate(const std::set<int>& inUse, std::chrono::steady_clock::duration idle)
+{
+	const auto cutoff = std::chrono::steady_clock::now() - idle;
+
+	std::vector<LiveGamePtr> games; // Destroyed outside the lock.
+	size_t nLoaded = 0;
+	{
+		std::lock_guard<std::recursive_mutex> lock(s_mutex);
+		for (auto it = s_liveGames.begin(); it != s_liveGames.end();)
+			if (CanHibernate(**it, inUse, cutoff))
+			{
+				s_hibernated.insert((*it)->GetID());
+				s_liveIndex.erase((*it)->GetID());
+				games.push_back(std::move(*it));
+				it = s_liveGames.erase(it);
+			}
+			else
+				++it;
+		nLoaded = s_liveGames.size();
+	}
+
+	if (!games.empty())
+		std::cout << "INFO: Hibernated " << games.size() << " game(s), " << nLoaded << " still loaded" << std::endl;
+}
+
+bool Games::CanHibernate(const LiveGame& game, const std::set<int>& inUse, std::chrono::steady_clock::time_point cutoff)
+{
+	if (game.GetID() < 0 || inUse.count(game.GetID()) || !game.GetReviewGames().empty()) // Test games aren't saved. 
+		return false;
+
+	// A lane we can't lock is busy. Nothing else can lock it once we've checked: nobody's in the game, and we hold the lobby lane.
+	std::unique_lock<std::mutex> laneLock(game.GetLaneMutex(), std::try_to_lock);
+	if (!laneLock || game.GetLastActive() > cutoff)
+		return false;
+
+	if (SaveThread::Instance() && SaveThread::Instance()->IsPending(game))
+		return false;
+
+	// A game that's never been committed has never been saved.
+	std::lock_guard<std::mutex> gameLock(game.GetMutex());
+	if (!game.IsSaved())
+		game.Save();
+	return game.IsSaved();
+}
+
+// Loads outside the lock, so other games aren't held up. If two threads wake the same game, the second copy is dropped.
+LiveGame& Games::Wake(int idGame)
+{
+	{
+		std::lock_guard<std::recursive_mutex> lock(s_mutex);
+		auto it = s_liveIndex.find(idGame);
+		if (it != s_liveIndex.end())
+			return *it->second;
+		VERIFY_MODEL(s_hibernated.count(idGame));
+	}
+
+	std::wstring path = ::FormatString(L"%0%1.xml", GetLiveGamePath(), idGame);
+	LiveGamePtr pGame(new LiveGame);
+	VERIFY_SERIAL_MSG(Kernel::WStringToString(path), Serial::LoadClass(DurableFile::GetLoadPath(path).wstring(), *pGame));
+	pGame->LoadJournal();
+
+	std::lock_guard<std::recursive_mutex> lock(s_mutex);
+	auto it = s_liveIndex.find(idGame);
+	if (it != s_liveIndex.end())
+		return *it->second; // Woken while we were loading.
+
+	LiveGame& game = *pGame;
+	s_hibernated.erase(idGame);
+	s_liveIndex[idGame] = &game;
+	s_liveGames.push_back(std::move(pGame));
+
+	Players::RejoinGame(game);
+
+	std::cout << "INFO: Woke game: " << game.GetName() << std::endl;
+	return game;
 }
@@ -2,6 +2,10 @@
 
 #include "App.h"
 
+#include <chrono>
+#include <set>
+#include <unordered_map>
+
 class LiveGame;
 class ReviewGame;
 class Game;
@@ -20,7 +24,8 @@ public:
 	static LiveGame& AddTest(Player& owner);
 	static ReviewGame& AddReview(Player& owner, const LiveGame& live);
 	static void DeleteReview(int idGame);
-	static const std::vector<LiveGamePtr>& GetLiveGames() { return s_liveGames; }
+	static const std::vector<LiveGamePtr>& GetLiveGames() { return s_liveGames; } // Not hibernated ones.
+	static int GetLiveGameCount(); // Including hibernated ones.
 	static const std::vector<ReviewGamePtr>& GetReviewGames() { return s_reviewGames; }
 	static const Game& Get(int idGame);
 	static const LiveGame& GetLive(int idGame);
@@ -29,8 +34,21 @@ public:
 	static bool IsLiveGame(int idGame);
 	static bool IsReviewGame(int idGame);
 
+	// Saves and unloads live games that aren't in inUse, have no reviews and haven't been touched for idle.
+	// Get and GetLive load them again. Lobby lane only: that's the only way into them. 
+	static void Hibernate(const std::set<int>& inUse, std::chrono::steady_clock::duration idle);
+
 private:
+	static bool CanHibernate(const LiveGame& game, const std::set<int>& inUse, std::chrono::steady_clock::time_point cutoff);
+	static LiveGame& Wake(int idGame);
+
+	// Guards the containers against lookups from game lanes. They're only modified in the lobby lane, 
+	// so the lobby lane can iterate them without it.
+	static std::recursive_mutex s_mutex;
 	static std::vector<LiveGamePtr> s_liveGames;
 	static std::vector<ReviewGamePtr> s_reviewGames;
+	static std::unordered_map<int, LiveGame*> s_liveIndex; // By ID, kept in step with the vectors.
+	static std::unordered_map<int, ReviewGame*> s_reviewIndex;
+	static std::set<int> s_hibernated; // Live games that are only on disk.
 	static int s_nNextGameID, s_nNextTestGameID;
 };
\ No newline at end of file
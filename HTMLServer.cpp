@@ -1,8 +1,6 @@
 #include "stdafx.h"
 #include "HTMLServer.h"
 
-#include <fstream>
-
 #include "App.h"
 #include "Game.h"
 #include "Controller.h"
@@ -10,35 +8,24 @@
 #include "Invitations.h"
 #include "Util.h"
 #include "PlayerList.h"
-
-namespace
-{
-	std::string LoadFile(const char* path)
-	{
-		std::string s, line;
-		std::ifstream file(path);
-		if (file.is_open())
-		{
-			std::stringstream buffer;
-			buffer << file.rdbuf();
-			s = buffer.str();
-			file.close();
-		}
-		return s;
-	}
-}
+#include "Player.h"
 
 typedef std::unique_ptr<Game> GamePtr;
 std::vector<GamePtr> games;
 
-HTMLServer::HTMLServer() : MongooseServer(8999)
+HTMLServer::HTMLServer() : MongooseServer(8999), m_assets("web"), m_dummyHash(Player::HashPassword("dummy"))
 {
 }
 
-Player* HTMLServer::Authenticate(const std::string& email, const std::string& password)
+// An unknown email is checked against a dummy hash, so it costs a token and takes as long as a known one.
+PasswordHasher::Result HTMLServer::Authenticate(const std::string& email, const std::string& password, const std::string& address, Player*& pPlayer)
 {
-	Player* pPlayer = Players::Find(email);
-	return pPlayer && pPlayer->CheckPassword(password) ? pPlayer : nullptr;
+	Player* pFound = Players::Find(email);
+
+	bool bMatch = false;
+	auto result = m_hasher.Check(address, password, pFound ? pFound->GetPasswordHash() : m_dummyHash, bMatch);
+	pPlayer = pFound && bMatch ? pFound : nullptr;
+	return result;
 }
 
 bool HTMLServer::Authenticate(int playerId, const StringMap& cookies)
@@ -62,7 +49,15 @@ std::string HTMLServer::OnHTTPRequest(const std::string& url, const std::string&
 		auto email = postData.Get("email");
 		auto password = postData.Get("password");
 
-		if (Player* player = Authenticate(email, password))
+		Player* player = nullptr;
+		switch (Authenticate(email, password, request.GetRemoteAddress(), player))
+		{
+		case PasswordHasher::Result::Busy: return CreateRedirectResponse("/login.html?failed=busy");
+		case PasswordHasher::Result::Limited: return CreateRedirectResponse("/login.html?failed=limited");
+		default: break;
+		}
+
+		if (player)
 		{
 			players.Add(*player);
 			return players.GetResponse();
@@ -95,7 +90,18 @@ std::string HTMLServer::OnHTTPRequest(const std::string& url, const std::string&
 		if (!Invitations::Find(code))
 			return redirect("invalid_code");
 
-		Player& player = Players::Add(email, name, password);
+		std::string passwordHash;
+		switch (m_hasher.Hash(request.GetRemoteAddress(), password, passwordHash))
+		{
+		case PasswordHasher::Result::Busy: return redirect("busy");
+		case PasswordHasher::Result::Limited: return redirect("limited");
+		default: break;
+		}
+
+		if (Players::Find(email)) // Again, in case someone else got there while we were hashing.
+			return redirect("email_taken");
+
+		Player& player = Players::Add(email, name, passwordHash);
 		Invitations::Remove(code);
 
 		players.Add(player);
@@ -114,14 +120,14 @@ std::string HTMLServer::OnHTTPRequest(const std::string& url, const std::string&
 
 	if (url == "/login.html")
 	{
-		std::string sPage = LoadFile("web\\login.html");
+		auto pAsset = m_assets.Find(url);
+		VERIFY(!!pAsset);
 
 		std::string js;
 		for (auto* player : players.GetPlayers())
 			js += ::FormatString("{ id:%0, name:'%1' }, ", player->GetID(), Util::ReplaceAll(player->GetName(), "'", "\\'"));
-		sPage = Util::ReplaceAll(sPage, "%PLAYER_LIST%", js);
 
-		return CreateOKResponse(sPage);
+		return CreateOKResponse(pAsset->page.Render({ { "%PLAYER_LIST%", js } }));
 	}
 
 	if (url == "/")
@@ -133,13 +139,36 @@ std::string HTMLServer::OnHTTPRequest(const std::string& url, const std::string&
 		ASSERT(host.substr(host.size() - 5) == ":8999");
 		std::string wsURL = GetWebSocketScheme() + "://" + host.substr(0, host.size() - 4) + "8998";
 			
-		std::string sPage = LoadFile("web\\game.html");
-		sPage = Util::ReplaceAll(sPage, "%PLAYER_ID%", FormatInt(player->GetID()));
-		sPage = Util::ReplaceAll(sPage, "%PLAYER_NAME%", Util::ReplaceAll(player->GetName(), "'", "\'"));
-		sPage = Util::ReplaceAll(sPage, "%WSURL%", wsURL);
+		auto pAsset = m_assets.Find("/game.html");
+		VERIFY(!!pAsset);
 
-		return CreateOKResponse(sPage);
+		return CreateOKResponse(pAsset->page.Render(
+		{
+			{ "%PLAYER_ID%", FormatInt(player->GetID()) },
+			{ "%PLAYER_NAME%", Util::ReplaceAll(player->GetName(), "'", "\'") },
+			{ "%WSURL%", wsURL },
+		}));
 	}
 
+	if (auto pAsset = m_assets.Find(url))
+		return CreateAssetResponse(*pAsset, request);
+
 	return ""; // Default request handling. 
 }
+
+// Browsers revalidate with the ETag every time, since our file names don't change when their content does.
+std::string HTMLServer::CreateAssetResponse(const AssetCache::Asset& asset, const Request& request) const
+{
+	if (request.GetHeader("If-None-Match") == asset.etag)
+		return CreateNotModifiedResponse(asset.etag);
+
+	std::string headers = ::FormatString("ETag: %0\r\nCache-Control: no-cache\r\n", asset.etag);
+
+	const bool bGzip = !asset.gzipped.empty() && request.GetHeader("Accept-Encoding").find("gzip") != std::string::npos;
+	if (!asset.gzipped.empty())
+		headers += "Vary: Accept-Encoding\r\n";
+	if (bGzip)
+		headers += "Content-Encoding: gzip\r\n";
+
+	return CreateContentResponse(bGzip ? asset.gzipped : asset.content, asset.contentType, headers);
+}
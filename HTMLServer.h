@@ -1,6 +1,8 @@
 #pragma once
 
 #include "MongooseServer.h"
+#include "AssetCache.h"
+#include "PasswordHasher.h"
 
 class Player;
 
@@ -9,10 +11,15 @@ class HTMLServer : public MongooseServer
 public:
 	HTMLServer();
 
-	static Player* Authenticate(const std::string& email, const std::string& password);
 	static bool Authenticate(int playerId, const StringMap& cookies);
 
 	virtual std::string OnHTTPRequest(const std::string& url, const std::string& host, const Request& request) override;
 
 private:
+	PasswordHasher::Result Authenticate(const std::string& email, const std::string& password, const std::string& address, Player*& pPlayer);
+	std::string CreateAssetResponse(const AssetCache::Asset& asset, const Request& request) const;
+
+	AssetCache m_assets;
+	PasswordHasher m_hasher;
+	const std::string m_dummyHash; // For unknown emails.
 };
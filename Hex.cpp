@@ -7,6 +7,7 @@
 #include "Game.h"
 #include "Technology.h"
 #include "HexDefs.h"
+#include "StateHash.h"
 
 Square::Square(Hex& hex, int index) : m_hex(hex), m_index(index)
 {
@@ -147,13 +148,13 @@ void Fleet::Load(const Serial::LoadNode& node)
 
 Hex::Hex() : 
 	m_id(0), m_nRotation(0), m_discovery(DiscoveryType::None), m_colour(Colour::None), m_pDef(nullptr), 
-	m_bOrbital(false), m_bMonolith(false)
+	m_bOrbital(false), m_bMonolith(false), m_hash(0), m_pOwnerHash(nullptr)
 {
 }
 
 Hex::Hex(int id, const MapPos& pos, int nRotation) : 
 	m_id(id), m_pos(pos), m_nRotation(nRotation), m_discovery(DiscoveryType::None), m_colour(Colour::None), m_pDef(&HexDefs::Get(id)),
-	m_bOrbital(false), m_bMonolith(false)
+	m_bOrbital(false), m_bMonolith(false), m_hash(0), m_pOwnerHash(nullptr)
 {
 	VERIFY_MODEL_MSG("Invalid rotation", nRotation >= 0 && nRotation < 6);
 
@@ -161,12 +162,13 @@ Hex::Hex(int id, const MapPos& pos, int nRotation) :
 		AddShip(ShipType::Ancient, Colour::None);
 
 	InitSquares();
+	m_hash = ComputeHash();
 }
 
 Hex::Hex(const Hex& rhs) : 
 	m_id(rhs.m_id), m_pos(rhs.m_pos), m_nRotation(rhs.m_nRotation), m_fleets(rhs.m_fleets),
 	m_discovery(rhs.m_discovery), m_colour(rhs.m_colour), m_occupied(rhs.m_occupied), m_pDef(rhs.m_pDef),
-	m_bOrbital(rhs.m_bOrbital), m_bMonolith(rhs.m_bMonolith)
+	m_bOrbital(rhs.m_bOrbital), m_bMonolith(rhs.m_bMonolith), m_hash(rhs.m_hash), m_pOwnerHash(nullptr)
 {
 	InitSquares();
 }
@@ -195,13 +197,61 @@ void Hex::InitSquares()
 		m_squares.push_back(Square(*this, i));
 }
 
+// Each hash key includes the hex ID, so equal features in different hexes don't cancel out in the map hash.
+uint64_t Hex::GetHashKey(HashFeature feature, int a, int b, int c) const
+{
+	return StateHash::GetKey(m_id, (int)feature, a, b, c);
+}
+
+uint64_t Hex::ComputeHash() const
+{
+	uint64_t hash = GetHashKey(HashFeature::Base, m_pos.GetX(), m_pos.GetY(), m_nRotation);
+	if (m_colour != Colour::None)
+		hash ^= GetHashKey(HashFeature::Colour, (int)m_colour);
+	for (int i : m_occupied)
+		hash ^= GetHashKey(HashFeature::Occupied, i);
+	for (auto& fleet : m_fleets)
+		for (auto& squadron : fleet.GetSquadrons())
+			hash ^= GetHashKey(HashFeature::Squadron, (int)fleet.GetColour(), (int)squadron.GetType(), squadron.GetShipCount());
+	if (m_discovery != DiscoveryType::None)
+		hash ^= GetHashKey(HashFeature::Discovery, (int)m_discovery);
+	if (m_bOrbital)
+		hash ^= GetHashKey(HashFeature::Orbital);
+	if (m_bMonolith)
+		hash ^= GetHashKey(HashFeature::Monolith);
+	return hash;
+}
+
+void Hex::ToggleHash(uint64_t key)
+{
+	m_hash ^= key;
+	if (m_pOwnerHash)
+		*m_pOwnerHash ^= key;
+}
+
+void Hex::ToggleSquadronHash(Colour colour, ShipType type)
+{
+	if (int count = GetShipCount(colour, type))
+		ToggleHash(GetHashKey(HashFeature::Squadron, (int)colour, (int)type, count));
+}
+
+void Hex::SetPos(const MapPos& pos)
+{
+	m_pos = pos;
+	ToggleHash(m_hash ^ ComputeHash());
+}
+
 void Hex::SetSquareOccupied(int i, bool b) 
 {
 	VERIFY_MODEL(InRange(m_squares, i));
+	if (b == IsSquareOccupied(i))
+		return;
+
 	if (b)
 		m_occupied.insert(i);
 	else
 		m_occupied.erase(i);
+	ToggleHash(GetHashKey(HashFeature::Occupied, i));
 }
 
 bool Hex::IsSquareOccupied(int i) const 
@@ -268,6 +318,7 @@ const Squadron* Hex::FindSquadron(Colour c, ShipType type) const
 
 void Hex::AddShip(ShipType type, Colour colour)
 {
+	ToggleSquadronHash(colour, type);
 	auto* fleet = FindFleet(colour);
 	if (!fleet)
 	{
@@ -275,6 +326,7 @@ void Hex::AddShip(ShipType type, Colour colour)
 		fleet = &m_fleets.back();
 	}
 	fleet->AddShip(type);
+	ToggleSquadronHash(colour, type);
 }
 
 void Hex::RemoveShip(ShipType type, Colour colour)
@@ -282,9 +334,11 @@ void Hex::RemoveShip(ShipType type, Colour colour)
 	for (auto fleetIt = m_fleets.begin(); fleetIt != m_fleets.end(); ++fleetIt)
 		if (fleetIt->GetColour() == colour)
 		{
+			ToggleSquadronHash(colour, type);
 			fleetIt->RemoveShip(type);
 			if (fleetIt->GetSquadrons().empty())
 				m_fleets.erase(fleetIt);
+			ToggleSquadronHash(colour, type);
 			return;
 		}
 
@@ -420,6 +474,7 @@ bool Hex::CanExploreFrom(const Team& team) const
 void Hex::SetColour(Colour c)
 {
 	VERIFY_MODEL((c == Colour::None) != (m_colour == Colour::None));
+	ToggleHash(GetHashKey(HashFeature::Colour, (int)(c == Colour::None ? m_colour : c)));
 	m_colour = c;
 }
 
@@ -441,6 +496,7 @@ bool Hex::HasNeighbour(const Map& map, bool bWormholeGen) const
 void Hex::RemoveDiscoveryTile()
 {
 	VERIFY_MODEL(m_discovery != DiscoveryType::None);
+	ToggleHash(GetHashKey(HashFeature::Discovery, (int)m_discovery));
 	m_discovery = DiscoveryType::None;
 }
 
@@ -448,6 +504,21 @@ void Hex::SetDiscoveryTile(DiscoveryType type)
 {
 	VERIFY_MODEL(m_discovery == DiscoveryType::None);
 	m_discovery = type;
+	ToggleHash(GetHashKey(HashFeature::Discovery, (int)m_discovery));
+}
+
+void Hex::SetOrbital(bool b)
+{
+	if (b != m_bOrbital)
+		ToggleHash(GetHashKey(HashFeature::Orbital));
+	m_bOrbital = b;
+}
+
+void Hex::SetMonolith(bool b)
+{
+	if (b != m_bMonolith)
+		ToggleHash(GetHashKey(HashFeature::Monolith));
+	m_bMonolith = b;
 }
 
 Square* Hex::FindSquare(SquareType type, bool bOccupied)
@@ -488,6 +559,7 @@ void Hex::Load(const Serial::LoadNode& node)
 
 	m_pDef = &HexDefs::Get(m_id);
 	InitSquares();
+	m_hash = ComputeHash();
 }
 
 DEFINE_ENUM_NAMES(SquareType) { "Money", "Science", "Materials", "Any", "Orbital", "" };
@@ -7,6 +7,7 @@
 #include <vector>
 #include <bitset>
 #include <memory>
+#include <cstdint>
 
 enum class Resource;
 enum class ShipType;
@@ -145,7 +146,7 @@ public:
 
 	int GetID() const { return m_id; }
 	const MapPos& GetPos() const { return m_pos; }
-	void SetPos(const MapPos& pos) { m_pos = pos; }
+	void SetPos(const MapPos& pos);
 	int GetRotation() const { return m_nRotation; }
 	const std::vector<Square>& GetSquares() const { return m_squares; }
 	std::vector<Square>& GetSquares() { return m_squares; }
@@ -165,17 +166,27 @@ public:
 
 	bool HasNeighbour(const Map& map, bool bWormholeGen) const;
 
-	void SetOrbital(bool b) { m_bOrbital = b; }
-	void SetMonolith(bool b) { m_bMonolith = b; }
+	void SetOrbital(bool b);
+	void SetMonolith(bool b);
 	bool HasOrbital() const { return m_bOrbital; }
 	bool HasMonolith() const { return m_bMonolith; }
 
+	uint64_t GetHash() const { return m_hash; }
+	void AttachHash(uint64_t* pOwnerHash) { m_pOwnerHash = pOwnerHash; }
+
 	void Save(Serial::SaveNode& node) const;
 	void Load(const Serial::LoadNode& node);
 
 private:
+	enum class HashFeature { Base, Colour, Occupied, Squadron, Discovery, Orbital, Monolith };
+
 	const HexDef& GetDef() const { return *m_pDef; }
 
+	uint64_t GetHashKey(HashFeature feature, int a = 0, int b = 0, int c = 0) const;
+	uint64_t ComputeHash() const;
+	void ToggleHash(uint64_t key);
+	void ToggleSquadronHash(Colour colour, ShipType type);
+
 	void InitSquares();
 
 	void SetSquareOccupied(int i, bool b);
@@ -193,6 +204,10 @@ private:
 	Colour m_colour;
 	std::set<int> m_occupied;
 	bool m_bOrbital, m_bMonolith;
+
+	// Not saved.
+	uint64_t m_hash;
+	uint64_t* m_pOwnerHash; // Map hash, updated with ours.
 };
 
 typedef std::unique_ptr<Hex> HexPtr;
@@ -31,7 +31,7 @@ void IncomeRecord::Apply(bool bDo, const Game& game, const Team& team, GameState
 
 void IncomeRecord::Update(const Game& game, const Team& team, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateStorageTrack(team));
+	context.SendSharedMessage<Output::UpdateStorageTrack>(::EnumToString(team.GetColour()), team);
 }
 
 std::string IncomeRecord::GetTeamMessage() const
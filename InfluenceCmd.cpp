@@ -137,7 +137,7 @@ std::vector<MapPos> InfluenceDstCmd::GetDests(const LiveGame& game) const
 	const bool bWormholeGen = team.HasTech(TechType::WormholeGen);
 
 	const Map& map = game.GetMap();
-	for (auto& h : map.GetHexes())
+	for (auto h : map.GetHexes())
 	{
 		if (!h.second->IsOwned())
 			if (h.second->HasShip(team.GetColour()) && !h.second->HasForeignShip(team.GetColour())) // "a hex where only you have a Ship"
@@ -39,8 +39,8 @@ void InfluenceRecord::Apply(bool bDo, const Game& game, const Team& team, GameSt
 
 void InfluenceRecord::Update(const Game& game, const Team& team, const RecordContext& context) const 
 {
-	context.SendMessage(Output::UpdateMap(game));
-	context.SendMessage(Output::UpdateInfluenceTrack(team));
+	context.SendMapDelta();
+	context.SendSharedMessage<Output::UpdateInfluenceTrack>(::EnumToString(team.GetColour()), team);
 }
 
 void InfluenceRecord::Save(Serial::SaveNode& node) const 
@@ -56,6 +56,8 @@ MessagePtr CreateCommand(const Json::Element& root)
 		return MessagePtr(new AdvanceReview);
 	if (type == "retreat_review")
 		return MessagePtr(new RetreatReview);
+	if (type == "seek_review")
+		return MessagePtr(new SeekReview(root));
 	if (type == "create_game")
 		return MessagePtr(new CreateGame);
 	if (type == "start_game")
@@ -72,6 +74,10 @@ MessagePtr CreateCommand(const Json::Element& root)
 		return MessagePtr(new FinishUpkeep);
 	if (type == "chat")
 		return MessagePtr(new Chat(root));
+	if (type == "fetch_logs")
+		return MessagePtr(new FetchLogs(root));
+	if (type == "fetch_map")
+		return MessagePtr(new FetchMap);
 	if (type == "query_blueprint_stats")
 		return MessagePtr(new QueryBlueprintStats(root));
 
@@ -141,12 +147,24 @@ const LiveGame& Message::GetLiveGame(const Player& player) const
 	return *pGame;
 }
 
+const LiveGame* Message::GetLaneGame(const Player& player) const
+{
+	if (const ReviewGame* pReview = dynamic_cast<const ReviewGame*>(player.GetCurrentGame()))
+		return &Games::GetLive(pReview->GetLiveGameID());
+	return player.GetCurrentLiveGame();
+}
+
 //-----------------------------------------------------------------------------
 	
-Register::Register(const Json::Element& node) : m_idPlayer(0)
+Register::Register(const Json::Element& node) : m_idPlayer(0), m_epoch(0), m_lastSeq(0), m_bBinary(false), m_bDeflate(false)
 {
 	m_idPlayer = node.GetAttributeInt("player");
 	VERIFY_INPUT(m_idPlayer > 0);
+
+	node.GetAttribute("epoch", m_epoch);
+	node.GetAttribute("last_seq", m_lastSeq);
+	node.GetAttribute("binary", m_bBinary);
+	node.GetAttribute("deflate", m_bDeflate);
 }
 
 EnterGame::EnterGame(const Json::Element& node) : m_idGame(0)
@@ -171,6 +189,11 @@ bool EnterGame::Process(Controller& controller, Player& player) const
 	return true;
 }
 
+const LiveGame* EnterGame::GetLaneGame(const Player& player) const
+{
+	return Games::IsLiveGame(m_idGame) ? &Games::GetLive(m_idGame) : nullptr;
+}
+
 bool ExitGame::Process(Controller& controller, Player& player) const 
 {
 	const Game* pGame = player.GetCurrentGame();
@@ -178,7 +201,7 @@ bool ExitGame::Process(Controller& controller, Player& player) const
 
 	player.SetCurrentGame(nullptr);
 	controller.SendMessage(Output::ShowGameList(), player);
-	controller.SendUpdateGameList(&player);
+	controller.SendUpdateGameList(player);
 	return true;
 }
 
@@ -195,7 +218,7 @@ bool JoinGame::Process(Controller& controller, Player& player) const
 	session.Commit();
 
 	controller.SendMessage(Output::UpdateLobby(*game), *game);
-	controller.SendUpdateGameList();
+	controller.SendUpdateGameListEntry(*game);
 	controller.SendMessage(Output::UpdateLobbyControls(player), player);
 
 	return true;
@@ -248,11 +271,36 @@ bool RetreatReview::Process(Controller& controller, Player& player) const
 	return true;
 }
 
+SeekReview::SeekReview(const Json::Element& node) : m_idRecord(0), m_round(-1)
+{
+	node.GetAttribute("record_id", m_idRecord);
+	node.GetAttribute("round", m_round);
+	VERIFY_INPUT((m_idRecord > 0) != (m_round >= 0));
+}
+
+bool SeekReview::Process(Controller& controller, Player& player) const 
+{
+	const ReviewGame* pReview = player.GetCurrentReviewGame();
+	VERIFY_INPUT_MSG(player.GetName(), !!pReview);
+
+	Record::DoImmediate(*pReview, [&](ReviewGame& game) 
+	{
+		if (m_idRecord > 0)
+			game.SeekToRecord(m_idRecord);
+		else
+			game.SeekToRound(m_round);
+	});
+
+	controller.SendUpdateGame(*pReview, &player); // Includes UpdateReviewUI.
+	return true;
+}
+
 bool CreateGame::Process(Controller& controller, Player& player) const 
 {
 	std::ostringstream ss;
-	ss << "Game " <<  Games::GetLiveGames().size() + 1;
+	ss << "Game " <<  Games::GetLiveGameCount() + 1;
 	LiveGame& game = Games::Add(ss.str(), player);
+	controller.SendUpdateGameListEntry(game);
 
 	DoEnterGame(controller, player, game);
 
@@ -271,7 +319,7 @@ bool StartGame::Process(Controller& controller, Player& player) const
 	session.Open().StartChooseTeamGamePhase();
 	session.Commit();
 
-	controller.SendUpdateGameList();
+	controller.SendUpdateGameListEntry(*pGame);
 	controller.SendUpdateGame(*pGame);
 
 	return true;	
@@ -396,6 +444,32 @@ bool Chat::Process(Controller& controller, Player& player) const
 	return true;
 }
 
+FetchLogs::FetchLogs(const Json::Element& node) : m_idBefore(0)
+{
+	node.GetAttribute("before", m_idBefore);
+	VERIFY_INPUT(m_idBefore > 0);
+}
+
+bool FetchLogs::Process(Controller& controller, Player& player) const
+{
+	const Game* pGame = player.GetCurrentGame();
+	VERIFY_INPUT_MSG(player.GetName(), !!pGame);
+
+	int idCursor = 0;
+	auto page = pGame->GetLogCache().GetPage(m_idBefore, idCursor);
+	controller.SendMessage(Output::PrependLog(page, idCursor), player);
+	return true;
+}
+
+bool FetchMap::Process(Controller& controller, Player& player) const
+{
+	const Game* pGame = player.GetCurrentGame();
+	VERIFY_INPUT_MSG(player.GetName(), !!pGame);
+
+	controller.SendSharedMessage<Output::UpdateMap>(*pGame, "", &player, *pGame);
+	return true;
+}
+
 SlotChanges::SlotChanges(const Json::Array& node)
 {
 	for (Json::Element child : node)
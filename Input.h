@@ -25,6 +25,11 @@ public:
 	virtual ~Message() {}
 	virtual bool Process(Controller& controller, Player& player) const { return true; }
 
+	// Every message holds the lane of the live game it touches. Lobby messages also hold the lobby lane, 
+	// so they can touch the game list; other messages for different games are processed in parallel.
+	virtual bool IsLobbyMessage() const { return true; }
+	virtual const LiveGame* GetLaneGame(const Player& player) const; // Player's current game, or its review's live game.
+
 protected:
 	const LiveGame& GetLiveGame(const Player& player) const;
 };
@@ -38,14 +43,22 @@ struct Register: Message
 {
 	Register(const Json::Element& node);
 	int GetPlayerID() const { return m_idPlayer; }
+	int GetEpoch() const { return m_epoch; }
+	int GetLastSeq() const { return m_lastSeq; }
+	bool IsBinary() const { return m_bBinary; }
+	bool WantsDeflate() const { return m_bDeflate; }
 private:
 	int m_idPlayer;
+	bool m_bBinary; // Wants BinaryCodec messages.
+	bool m_bDeflate; // Can inflate large messages.
+	int m_epoch, m_lastSeq; // Of the last frame the client got before reconnecting, if any.
 };
 
 struct EnterGame : Message
 {
 	EnterGame(const Json::Element& node);
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual const LiveGame* GetLaneGame(const Player& player) const override;
 	int m_idGame;
 };
 
@@ -74,11 +87,21 @@ struct ExitReview : Message
 struct AdvanceReview : Message 
 {
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
 };
 
 struct RetreatReview : Message 
 {
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
+};
+
+struct SeekReview : Message 
+{
+	SeekReview(const Json::Element& node);
+	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
+	int m_idRecord, m_round;
 };
 
 struct CreateGame : Message 
@@ -102,31 +125,50 @@ struct StartAction : Message
 {
 	StartAction(const Json::Element& node);
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
 	std::string m_action;
 };
 
 struct Undo : Message 
 {
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
 };
 
 struct Commit : Message 
 {
 	virtual bool Process(Controller& controller, Player& player) const override; 
+	virtual bool IsLobbyMessage() const override { return false; }
 };
 
 struct FinishUpkeep : Message
 {
 	virtual bool Process(Controller& controller, Player& player) const override;
+	virtual bool IsLobbyMessage() const override { return false; }
 };
 
 struct Chat : Message
 {
 	Chat(const Json::Element& node);
 	virtual bool Process(Controller& controller, Player& player) const override;
+	virtual bool IsLobbyMessage() const override { return false; }
 	std::string m_msg;
 };
 
+struct FetchLogs : Message
+{
+	FetchLogs(const Json::Element& node);
+	virtual bool Process(Controller& controller, Player& player) const override;
+	virtual bool IsLobbyMessage() const override { return false; }
+	int m_idBefore;
+};
+
+struct FetchMap : Message // After a gap in map deltas.
+{
+	virtual bool Process(Controller& controller, Player& player) const override;
+	virtual bool IsLobbyMessage() const override { return false; }
+};
+
 struct SlotChange
 {
 	ShipType ship;
@@ -142,6 +184,7 @@ struct QueryBlueprintStats : Message
 {
 	QueryBlueprintStats(const Json::Element& node);
 	virtual bool Process(Controller& controller, Player& player) const override;
+	virtual bool IsLobbyMessage() const override { return false; }
 	SlotChanges m_changes;
 };
 
@@ -151,6 +194,7 @@ class CmdMessage : public Message
 {
 public:
 	virtual bool Process(Controller& controller, Player& player) const;
+	virtual bool IsLobbyMessage() const override { return false; }
 };
 
 struct CmdExplorePos : CmdMessage
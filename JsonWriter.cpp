@@ -0,0 +1,195 @@
+#include "stdafx.h"
+#include "JsonWriter.h"
+
+#include <charconv>
+#include <cstring>
+
+const size_t JsonWriter::MaxPooledBuffers = 8;
+thread_local std::vector<std::unique_ptr<JsonWriter::Buffers>> JsonWriter::s_pool;
+
+JsonWriter::JsonWriter() : m_nextID(1)
+{
+	if (s_pool.empty())
+		m_pBuffers.reset(new Buffers);
+	else
+	{
+		m_pBuffers = std::move(s_pool.back());
+		s_pool.pop_back();
+	}
+
+	m_pBuffers->text = '{';
+	m_pBuffers->levels.push_back(Level { 0, '}', true }); // The document.
+}
+
+JsonWriter::~JsonWriter()
+{
+	if (s_pool.size() < MaxPooledBuffers)
+	{
+		m_pBuffers->text.clear();
+		m_pBuffers->levels.clear();
+		s_pool.push_back(std::move(m_pBuffers));
+	}
+}
+
+std::string JsonWriter::GetString() const
+{
+	auto& levels = m_pBuffers->levels;
+
+	std::string str;
+	str.reserve(m_pBuffers->text.size() + levels.size());
+	str = m_pBuffers->text;
+	for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+		str += it->closer;
+	return str;
+}
+
+void JsonWriter::WriteKey(const Element& parent, const char* name)
+{
+	auto& levels = m_pBuffers->levels;
+	auto& text = m_pBuffers->text;
+
+	VERIFY_MSG("JsonWriter: container already closed", parent.m_pWriter == this && parent.m_depth < (int)levels.size() && levels[parent.m_depth].id == parent.m_id);
+
+	while ((int)levels.size() > parent.m_depth + 1)
+	{
+		text += levels.back().closer;
+		levels.pop_back();
+	}
+
+	Level& level = levels.back();
+	if (!level.bEmpty)
+		text += ',';
+	level.bEmpty = false;
+
+	VERIFY_MSG("JsonWriter: arrays don't have names", (level.closer == '}') == (name != nullptr));
+	if (name)
+	{
+		AppendEscaped(name, std::strlen(name));
+		text += ':';
+	}
+}
+
+void JsonWriter::WriteInt(const Element& parent, const char* name, long long val)
+{
+	WriteKey(parent, name);
+
+	char buf[24];
+	auto result = std::to_chars(buf, buf + sizeof buf, val);
+	m_pBuffers->text.append(buf, result.ptr);
+}
+
+void JsonWriter::WriteString(const Element& parent, const char* name, const char* val, size_t len)
+{
+	WriteKey(parent, name);
+	AppendEscaped(val, len);
+}
+
+void JsonWriter::WriteRaw(const Element& parent, const char* name, const char* val)
+{
+	WriteKey(parent, name);
+	m_pBuffers->text += val;
+}
+
+int JsonWriter::Open(const Element& parent, const char* name, char opener, char closer)
+{
+	WriteKey(parent, name);
+	m_pBuffers->text += opener;
+	m_pBuffers->levels.push_back(Level { m_nextID, closer, true });
+	return m_nextID++;
+}
+
+void JsonWriter::AppendEscaped(const char* str, size_t len)
+{
+	auto& text = m_pBuffers->text;
+	text += '"';
+	for (const char* p = str; p != str + len; ++p)
+	{
+		const char c = *p;
+		switch (c)
+		{
+		case '"': text += "\\\""; break;
+		case '\\': text += "\\\\"; break;
+		case '\n': text += "\\n"; break;
+		case '\r': text += "\\r"; break;
+		case '\t': text += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				static const char hex[] = "0123456789abcdef";
+				const char esc[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+				text.append(esc, sizeof esc);
+			}
+			else
+				text += c;
+		}
+	}
+	text += '"';
+}
+
+//-----------------------------------------------------------------------------
+
+void JsonWriter::Element::SetAttribute(const char* name, bool val)
+{
+	m_pWriter->WriteRaw(*this, name, val ? "true" : "false");
+}
+
+void JsonWriter::Element::SetAttribute(const char* name, const char* val)
+{
+	m_pWriter->WriteString(*this, name, val, std::strlen(val));
+}
+
+void JsonWriter::Element::SetAttribute(const char* name, const std::string& val)
+{
+	m_pWriter->WriteString(*this, name, val.c_str(), val.size());
+}
+
+void JsonWriter::Element::SetRawAttribute(const char* name, const std::string& json)
+{
+	m_pWriter->WriteRaw(*this, name, json.c_str());
+}
+
+JsonWriter::Element JsonWriter::Element::AddElement(const char* name)
+{
+	int id = m_pWriter->Open(*this, name, '{', '}');
+	return Element(m_pWriter, m_depth + 1, id);
+}
+
+JsonWriter::Array JsonWriter::Element::AddArray(const char* name)
+{
+	int id = m_pWriter->Open(*this, name, '[', ']');
+	return Array(m_pWriter, m_depth + 1, id);
+}
+
+//-----------------------------------------------------------------------------
+
+void JsonWriter::Array::Append(bool val)
+{
+	m_pWriter->WriteRaw(AsElement(), nullptr, val ? "true" : "false");
+}
+
+void JsonWriter::Array::Append(const char* val)
+{
+	m_pWriter->WriteString(AsElement(), nullptr, val, std::strlen(val));
+}
+
+void JsonWriter::Array::Append(const std::string& val)
+{
+	m_pWriter->WriteString(AsElement(), nullptr, val.c_str(), val.size());
+}
+
+void JsonWriter::Array::AppendRaw(const std::string& json)
+{
+	m_pWriter->WriteRaw(AsElement(), nullptr, json.c_str());
+}
+
+JsonWriter::Element JsonWriter::Array::AppendElement()
+{
+	int id = m_pWriter->Open(AsElement(), nullptr, '{', '}');
+	return Element(m_pWriter, m_depth + 1, id);
+}
+
+JsonWriter::Array JsonWriter::Array::AppendArray()
+{
+	int id = m_pWriter->Open(AsElement(), nullptr, '[', ']');
+	return Array(m_pWriter, m_depth + 1, id);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Writes JSON text as it's built, with no DOM. Containers close when something is written to an outer one, 
+// so each container must be finished before its parent (or a sibling) is written to.
+// The text buffer is reused by later writers on the same thread.
+class JsonWriter
+{
+public:
+	class Array;
+
+	class Element
+	{
+	public:
+		Element() : m_pWriter(nullptr), m_depth(0), m_id(0) {}
+
+		template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+		void SetAttribute(const char* name, T val) { m_pWriter->WriteInt(*this, name, (long long)val); }
+		void SetAttribute(const char* name, bool val);
+		void SetAttribute(const char* name, const char* val);
+		void SetAttribute(const char* name, const std::string& val);
+		void SetRawAttribute(const char* name, const std::string& json); // Already serialised.
+
+		Element AddElement(const char* name);
+		Array AddArray(const char* name);
+
+	private:
+		friend class JsonWriter;
+		friend class Array;
+		Element(JsonWriter* pWriter, int depth, int id) : m_pWriter(pWriter), m_depth(depth), m_id(id) {}
+
+		JsonWriter* m_pWriter;
+		int m_depth, m_id;
+	};
+
+	class Array
+	{
+	public:
+		Array() : m_pWriter(nullptr), m_depth(0), m_id(0) {}
+
+		template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+		void Append(T val) { m_pWriter->WriteInt(AsElement(), nullptr, (long long)val); }
+		void Append(bool val);
+		void Append(const char* val);
+		void Append(const std::string& val);
+		void AppendRaw(const std::string& json); // Already serialised.
+
+		Element AppendElement();
+		Array AppendArray();
+
+	private:
+		friend class JsonWriter;
+		friend class Element;
+		Array(JsonWriter* pWriter, int depth, int id) : m_pWriter(pWriter), m_depth(depth), m_id(id) {}
+		Element AsElement() const { return Element(m_pWriter, m_depth, m_id); }
+
+		JsonWriter* m_pWriter;
+		int m_depth, m_id;
+	};
+
+	JsonWriter();
+	~JsonWriter();
+	JsonWriter(const JsonWriter&) = delete;
+	JsonWriter& operator=(const JsonWriter&) = delete;
+
+	Element GetDocument() { return Element(this, 0, 0); }
+	std::string GetString() const; // Closes whatever's still open.
+
+private:
+	struct Level
+	{
+		int id;
+		char closer;
+		bool bEmpty;
+	};
+	struct Buffers
+	{
+		std::string text;
+		std::vector<Level> levels;
+	};
+
+	void WriteKey(const Element& parent, const char* name); // Closes anything inside parent, then writes the separator and name.
+	void WriteInt(const Element& parent, const char* name, long long val);
+	void WriteString(const Element& parent, const char* name, const char* val, size_t len);
+	void WriteRaw(const Element& parent, const char* name, const char* val);
+	int Open(const Element& parent, const char* name, char opener, char closer); // Returns the new level's id.
+	void AppendEscaped(const char* str, size_t len);
+
+	static const size_t MaxPooledBuffers;
+	static thread_local std::vector<std::unique_ptr<Buffers>> s_pool; // Finished writers' buffers, which keep their capacity.
+
+	std::unique_ptr<Buffers> m_pBuffers;
+	int m_nextID;
+};
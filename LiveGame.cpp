@@ -11,15 +11,25 @@
 #include "UpkeepPhase.h"
 #include "Test.h"
 #include "ScorePhase.h"
+#include "DurableFile.h"
 
 #include <algorithm>
+#include <filesystem>
+#include <iostream>
 
-LiveGame::LiveGame() : m_gamePhase(GamePhase::Lobby), m_nextRecordID(1)
+const int LiveGame::CheckpointInterval = 50; // Journal entries between snapshots.
+bool LiveGame::s_bAudit = false;
+const int LiveGame::KeyframeInterval = 20;
+const size_t LiveGame::MaxKeyframes = 50;
+
+LiveGame::LiveGame() : m_gamePhase(GamePhase::Lobby), m_nextRecordID(1), m_idSnapshot(0), m_bSnapshotDue(true), 
+m_keyframeClock(0), m_lastActive(std::chrono::steady_clock::now()), m_bSaveQueued(false), m_bSaving(false)
 {
 }
 
 LiveGame::LiveGame(int id, const std::string& name, const Player& owner) : 
-Game(id, name, owner), m_gamePhase(GamePhase::Lobby), m_nextRecordID(1)
+Game(id, name, owner), m_gamePhase(GamePhase::Lobby), m_nextRecordID(1), m_idSnapshot(0), m_bSnapshotDue(true),
+m_keyframeClock(0), m_lastActive(std::chrono::steady_clock::now()), m_bSaveQueued(false), m_bSaving(false)
 {
 }
 
@@ -37,6 +47,8 @@ void LiveGame::EnjoinPlayer(const Player& player, bool join)
 		m_teams.push_back(TeamPtr(new Team(player.GetID())));
 	else
 		m_teams.erase(std::find_if(m_teams.begin(), m_teams.end(), [&](const TeamPtr& t) { return t.get() == team; } ));
+
+	m_bSnapshotDue = true;
 }
 
 void LiveGame::StartChooseTeamGamePhase()
@@ -54,6 +66,8 @@ void LiveGame::StartChooseTeamGamePhase()
 
 	m_techBag.Init();
 	m_discBag.Init();
+
+	m_bSnapshotDue = true;
 }
 
 void LiveGame::StartMainGamePhase()
@@ -63,6 +77,7 @@ void LiveGame::StartMainGamePhase()
 	m_gamePhase = GamePhase::Main;
 	m_state.Init(*this);
 	StartActionPhase();
+	m_bSnapshotDue = true;
 }
 
 Phase& LiveGame::GetPhase()
@@ -103,6 +118,7 @@ bool LiveGame::NeedCombat() const
 void LiveGame::StartActionPhase()
 {
 	m_pPhase = PhasePtr(new ActionPhase(this));
+	m_bSnapshotDue = true;
 }
 
 void LiveGame::FinishActionPhase(const std::vector<Colour>& passOrder)
@@ -133,28 +149,49 @@ void LiveGame::FinishActionPhase(const std::vector<Colour>& passOrder)
 		m_pPhase = PhasePtr(new CombatPhase(this));
 	else
 		m_pPhase = PhasePtr(new UpkeepPhase(this));
+
+	m_bSnapshotDue = true;
 }
 
 void LiveGame::FinishCombatPhase()
 {
 	m_pPhase = PhasePtr(new UpkeepPhase(this));
+	m_bSnapshotDue = true;
 }
 
 void LiveGame::StartScorePhase()
 {
 	m_pPhase = PhasePtr(new ScorePhase(this));
+	m_bSnapshotDue = true;
 }
 
 int LiveGame::PushRecord(std::unique_ptr<Record> pRec)
 {
-	GameState state(m_state, *this);
-	pRec->Undo(*this, nullptr);
-	pRec->Do(*this, nullptr);
-	VERIFY(m_state == state);
+	// Check that Undo restores the state exactly.
+	// That writes to the record's hexes again, but Do has already sent them, so they mustn't stay dirty.
+	const std::set<MapPos> dirty = m_state.GetMap().GetDirty();
+	uint64_t hash = m_state.GetHash();
+	if (s_bAudit)
+	{
+		GameState state(m_state, *this);
+		pRec->Undo(*this, nullptr);
+		pRec->Do(*this, nullptr);
+		VERIFY(m_state == state);
+		VERIFY(m_state.GetMap().GetHash() == m_state.GetMap().ComputeHash());
+	}
+	else
+	{
+		pRec->Undo(*this, nullptr);
+		pRec->Do(*this, nullptr);
+	}
+	VERIFY(m_state.GetHash() == hash);
+	m_state.GetMap().SetDirty(dirty);
 
 	int id = m_nextRecordID++;
 	pRec->SetID(id);
 	m_records.push_back(std::move(pRec));
+	m_journal.AddPush(id);
+
 	return id;
 }
 
@@ -166,9 +203,49 @@ RecordPtr LiveGame::PopRecord()
 
 	RecordPtr pRec = std::move(m_records[pop]);
 	m_records.erase(m_records.begin() + pop);
+	m_journal.AddPop(pRec->GetID());
+
+	// Keyframes after the popped record include it.
+	std::lock_guard<std::mutex> lock(m_keyframeMutex);
+	m_keyframes.erase(m_keyframes.upper_bound((int)pop), m_keyframes.end());
+
 	return pRec;
 }
 
+LiveGame::Keyframe LiveGame::FindKeyframe(int iRecord) const
+{
+	std::lock_guard<std::mutex> lock(m_keyframeMutex);
+	auto it = m_keyframes.upper_bound(iRecord);
+	if (it == m_keyframes.begin())
+		return Keyframe(0, nullptr);
+
+	(--it)->second.lastUsed = ++m_keyframeClock;
+	return Keyframe(it->first, it->second.pState);
+}
+
+// Cheap, since the copy shares everything with state.
+void LiveGame::AddKeyframe(int iRecord, const GameState& state) const
+{
+	VERIFY_MODEL(iRecord > 0 && iRecord % KeyframeInterval == 0);
+
+	std::lock_guard<std::mutex> lock(m_keyframeMutex);
+	auto& keyframe = m_keyframes[iRecord];
+	keyframe.lastUsed = ++m_keyframeClock;
+	if (keyframe.pState)
+		return;
+
+	keyframe.pState.reset(new GameState(state, const_cast<LiveGame&>(*this)));
+
+	if (m_keyframes.size() > MaxKeyframes)
+		m_keyframes.erase(std::min_element(m_keyframes.begin(), m_keyframes.end(), 
+			[](const std::pair<const int, KeyframeEntry>& lhs, const std::pair<const int, KeyframeEntry>& rhs) { return lhs.second.lastUsed < rhs.second.lastUsed; }));
+}
+
+int LiveGame::GetLastRecordID() const
+{
+	return m_records.empty() ? 0 : m_records.back()->GetID();
+}
+
 int LiveGame::GetLastPoppableRecord() const
 {
 	int lastPoppable = (int)m_records.size() - 1;
@@ -178,16 +255,16 @@ int LiveGame::GetLastPoppableRecord() const
 	return lastPoppable;
 }
 
-LiveGame::LogVec LiveGame::GetLogs() const
+const LogCache& LiveGame::GetLogCache() const
 {
-	LogVec logs;
-	for (auto& rec : m_records)
-	{
-		std::string msg = rec->GetMessage(*this);
-		if (!msg.empty())
-			logs.push_back(LogVec::value_type(rec->GetID(), msg));
-	}
-	return logs;
+	return const_cast<LiveGame*>(this)->GetLogCache();
+}
+
+LogCache& LiveGame::GetLogCache()
+{
+	if (!m_logCache.IsBuilt())
+		m_logCache.Build(*this);
+	return m_logCache;
 }
 
 const Team& LiveGame::GetTeamForTurn(int i) const
@@ -196,52 +273,164 @@ const Team& LiveGame::GetTeamForTurn(int i) const
 	return *m_teams[m_turnOrder[i]];
 }
 
+std::string LiveGame::GetSavePath(const std::string& ext) const
+{
+	std::ostringstream ss;
+	ss << "data/games/live/" << m_id << "." << ext;
+	return ss.str();
+}
+
 void LiveGame::Save() const
+{
+	std::vector<DurableFile::Item> items(1);
+	if (!PrepareSave(items[0]))
+		return;
+
+	DurableFile::Commit(items);
+	FinishSave(items[0]);
+}
+
+bool LiveGame::PrepareSave(DurableFile::Item& item) const
 {
 	if (m_id < 0)
+	{
+		m_journal.Clear();
+		return false;
+	}
+
+	// Records only rebuild the state in the main phase, so other phases are always saved in full.
+	// Otherwise snapshot periodically so the journal tail replayed on load stays short.
+	if (!m_bSnapshotDue && m_gamePhase == GamePhase::Main && m_journal.GetWrittenCount() < CheckpointInterval &&
+		m_journal.Append(GetSavePath("journal"), *this))
+	{
+		item = DurableFile::PrepareSync(GetSavePath("journal"));
+		return true;
+	}
+
+	// The snapshot carries the new ID. Until it's committed, the old snapshot and its journal are still current.
+	++m_idSnapshot;
+	m_bSnapshotDue = true;
+	m_journal.Clear(); // The snapshot includes them.
+	if (!DurableFile::Prepare(GetSavePath("xml"), [&](const std::filesystem::path& tmpPath) { return Serial::SaveClass(tmpPath.string(), *this); }, item))
+	{
+		--m_idSnapshot;
+		std::cerr << "WARNING: Failed to write snapshot: " << GetSavePath("xml") << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void LiveGame::FinishSave(const DurableFile::Item& item) const
+{
+	if (item.tmpPath.empty()) // Journal block.
+	{
+		if (!item.bOK)
+			m_bSnapshotDue = true; // It might not be on disk.
 		return;
+	}
 
-	std::ostringstream ss;
-	ss << "data/games/live/" << m_id << ".xml";
-	bool bOK = Serial::SaveClass(ss.str(), *this);
-	ASSERT(bOK);
+	if (!item.bOK)
+	{
+		--m_idSnapshot;
+		std::cerr << "WARNING: Failed to save snapshot: " << GetSavePath("xml") << std::endl;
+		return;
+	}
+
+	// A journal left over from the previous snapshot has the old ID, so it's ignored if the reset fails.
+	m_bSnapshotDue = !m_journal.Reset(GetSavePath("journal"), m_idSnapshot);
+	if (m_bSnapshotDue)
+		std::cerr << "WARNING: Failed to reset journal: " << GetSavePath("journal") << std::endl;
 }
 
-void LiveGame::Save(Serial::SaveNode& node) const 
+bool LiveGame::IsSaved() const
+{
+	std::error_code error;
+	return std::filesystem::exists(GetSavePath("xml"), error);
+}
+
+void LiveGame::LoadJournal()
+{
+	m_bSnapshotDue = !m_journal.Replay(GetSavePath("journal"), m_idSnapshot, *this);
+}
+
+void LiveGame::ReplayPushRecord(RecordPtr pRec)
+{
+	VERIFY_SERIAL_MSG(m_name, m_gamePhase == GamePhase::Main);
+	pRec->Do(*this, nullptr);
+	m_records.push_back(std::move(pRec));
+}
+
+void LiveGame::ReplayPopRecord(int idRecord)
+{
+	auto it = std::find_if(m_records.begin(), m_records.end(), [&](const RecordPtr& r) { return r->GetID() == idRecord; });
+	VERIFY_SERIAL_MSG(m_name, it != m_records.end());
+	(*it)->Undo(*this, nullptr);
+	m_records.erase(it);
+}
+
+void LiveGame::SaveProgress(Serial::SaveNode& node) const
 {
-	node.SaveCntr("records", m_records, Serial::ObjectSaver());
 	node.SaveObject("phase", m_pPhase);
 	node.SaveEnum("game_phase", m_gamePhase);
 	node.SaveType("next_record_id", m_nextRecordID);
 	node.SaveCntr("turn_order", m_turnOrder, Serial::TypeSaver());
+}
+
+void LiveGame::LoadProgress(const Serial::LoadNode& node)
+{
+	node.LoadObject("phase", m_pPhase);
+	node.LoadEnum("game_phase", m_gamePhase);
+	node.LoadType("next_record_id", m_nextRecordID);
+	m_turnOrder.clear();
+	node.LoadCntr("turn_order", m_turnOrder, Serial::TypeLoader());
+
+	if (m_pPhase)
+		m_pPhase->SetGame(*this);
+}
+
+void LiveGame::Save(Serial::SaveNode& node) const 
+{
+	node.SaveCntr("records", m_records, Serial::ObjectSaver());
+	SaveProgress(node);
+	node.SaveType("snapshot_id", m_idSnapshot);
 	__super::Save(node);
 
+	node.SaveType("state_record_id", GetLastRecordID());
 	node.SaveClass("state", m_state);
 }
 
 void LiveGame::Load(const Serial::LoadNode& node)
 {
 	node.LoadCntr("records", m_records, Serial::ObjectLoader());
-	node.LoadObject("phase", m_pPhase);
-	node.LoadEnum("game_phase", m_gamePhase);
-	node.LoadType("next_record_id", m_nextRecordID);
-	node.LoadCntr("turn_order", m_turnOrder, Serial::TypeLoader());
+	LoadProgress(node);
+	node.LoadType("snapshot_id", m_idSnapshot);
 	__super::Load(node);
 
-	GameState state(*this);
-	node.LoadClass("state", state);
+	int idStateRecord = -1;
+	node.LoadType("state_record_id", idStateRecord);
 
 	if (m_gamePhase == GamePhase::Main)
 	{
-		m_state.Init(*this);
-		for (auto& r : m_records)
-			r->Do(*this, nullptr);
+		if (s_bAudit || idStateRecord != GetLastRecordID())
+		{
+			// Rebuild from scratch and check against the saved state.
+			GameState state(*this);
+			node.LoadClass("state", state);
 
-		VERIFY(state == m_state);
+			m_state.Init(*this);
+			for (auto& r : m_records)
+				r->Do(*this, nullptr);
+
+			VERIFY(state == m_state);
+		}
+		else
+		{
+			node.LoadClass("state", m_state);
+			m_state.AttachTeams(*this);
+		}
 	}
 
-	if (m_pPhase)
-		m_pPhase->SetGame(*this);
+	m_bSnapshotDue = false;
 }
 
 DEFINE_ENUM_NAMES(LiveGame::GamePhase) { "Lobby", "ChooseTeam", "Main", "" };
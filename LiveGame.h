@@ -1,6 +1,12 @@
 #pragma once
 
 #include "Game.h"
+#include "GameJournal.h"
+#include "DurableFile.h"
+#include "LogCache.h"
+
+#include <atomic>
+#include <chrono>
 
 class Phase;
 class ActionPhase;
@@ -17,10 +23,11 @@ class LiveGame : public Game
 {
 	friend class TurnPhase;
 	friend class Phase;
+	friend class GameJournal;
+	friend class SaveThread;
 
 public:
 	enum class GamePhase { Lobby, ChooseTeam, Main };
-	typedef std::vector<std::pair<int, std::string>> LogVec;
 
 	LiveGame();
 	LiveGame(int id, const std::string& name, const Player& owner);
@@ -32,7 +39,8 @@ public:
 	void StartMainGamePhase();
 	virtual bool HasStarted() const override { return m_gamePhase != GamePhase::Lobby; }
 	virtual bool IsLive() const override { return true; }
-	virtual LogVec GetLogs() const override;
+	virtual const LogCache& GetLogCache() const override;
+	LogCache& GetLogCache();
 
 	GamePhase GetGamePhase() const { return m_gamePhase; }
 	
@@ -52,6 +60,14 @@ public:
 	const std::vector<RecordPtr>& GetRecords() const { return m_records; }
 	int GetLastPoppableRecord() const; 
 
+	// Review keyframes: snapshots of the state at multiples of KeyframeInterval records, shared by all reviews.
+	// Reviews add them as they step past, so only reviewed games have any. The least recently used go beyond MaxKeyframes.
+	typedef std::pair<int, std::shared_ptr<const GameState>> Keyframe; // Record index, state.
+	Keyframe FindKeyframe(int iRecord) const; // Nearest at or before iRecord, if any.
+	void AddKeyframe(int iRecord, const GameState& state) const;
+	static const int KeyframeInterval;
+	static const size_t MaxKeyframes;
+
 	const std::set<ReviewGame*> GetReviewGames() const { return m_reviewGames; }
 	void AddReviewGame(ReviewGame& game) const { m_reviewGames.insert(&game); }
 	void RemoveReviewGame(ReviewGame& game) const { m_reviewGames.erase(&game); }
@@ -68,19 +84,58 @@ public:
 	virtual void Save(Serial::SaveNode& node) const override;
 	virtual void Load(const Serial::LoadNode& node) override;
 
-	void Save() const;
+	void Save() const; // Holds the mutex until it's on disk.
+	void LoadJournal();
+
+	// A save in two halves, so the mutex needn't be held while it's committed. Both need the mutex.
+	bool PrepareSave(DurableFile::Item& item) const; // False if there's nothing to commit.
+	void FinishSave(const DurableFile::Item& item) const; // After committing item.
+
+	static void SetAudit(bool audit) { s_bAudit = audit; }
 	std::mutex& GetMutex() const { return m_mutex; }
+	std::mutex& GetLaneMutex() const { return m_laneMutex; }
+
+	// For hibernation. Both need the lane.
+	void Touch() const { m_lastActive = std::chrono::steady_clock::now(); }
+	std::chrono::steady_clock::time_point GetLastActive() const { return m_lastActive; }
+	bool IsSaved() const; // Has a snapshot on disk.
 
 private:
+	void SaveProgress(Serial::SaveNode& node) const;
+	void LoadProgress(const Serial::LoadNode& node);
+	void ReplayPushRecord(RecordPtr pRec);
+	void ReplayPopRecord(int idRecord);
+	std::string GetSavePath(const std::string& ext) const;
+	int GetLastRecordID() const;
+
+	static const int CheckpointInterval;
+	static bool s_bAudit; // Full replay on load, deep state comparison on push.
+
 	std::vector<RecordPtr> m_records;
 	GamePhase m_gamePhase;
 	PhasePtr m_pPhase;
 	int m_nextRecordID;
 	std::vector<int> m_turnOrder;
+	mutable int m_idSnapshot; // Identifies the journal that extends this snapshot.
 
 	// Not saved.
-	mutable std::mutex m_mutex;
+	mutable GameJournal m_journal;
+	LogCache m_logCache; // Built on first use.
+	mutable bool m_bSnapshotDue;
+	mutable std::mutex m_mutex; // Held while modifying or saving.
+	mutable std::mutex m_laneMutex; // Held while processing a message for this game or its reviews.
 	mutable std::set<ReviewGame*> m_reviewGames;
+	struct KeyframeEntry
+	{
+		std::shared_ptr<const GameState> pState;
+		unsigned int lastUsed; // m_keyframeClock when it was last found or added.
+	};
+	mutable std::map<int, KeyframeEntry> m_keyframes;
+	mutable unsigned int m_keyframeClock;
+	mutable std::mutex m_keyframeMutex;
+	mutable std::chrono::steady_clock::time_point m_lastActive;
+	mutable std::atomic<bool> m_bSaveQueued; // Pushed to SaveThread, and its save hasn't started.
+	mutable std::atomic<bool> m_bSaving; // Prepared by SaveThread, and not yet finished.
 };
 
 DEFINE_UNIQUE_PTR(LiveGame)
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "LogCache.h"
+#include "LiveGame.h"
+#include "Output.h"
+#include "Record.h"
+
+#include <algorithm>
+
+const int LogCache::PageSize = 100;
+
+LogCache::LogCache() : m_bBuilt(false)
+{
+}
+
+void LogCache::Build(const LiveGame& game)
+{
+	m_entries.clear();
+	for (auto& rec : game.GetRecords())
+	{
+		std::string msg = rec->GetMessage(game);
+		if (!msg.empty())
+			m_entries.push_back(Vec::value_type(rec->GetID(), msg));
+	}
+	m_pPayload.reset();
+	m_bBuilt = true;
+}
+
+void LogCache::Add(int idRecord, const std::string& msg)
+{
+	if (!m_bBuilt || msg.empty())
+		return;
+
+	m_entries.push_back(Vec::value_type(idRecord, msg));
+	m_pPayload.reset();
+}
+
+// Usually the last entry.
+void LogCache::Remove(int idRecord)
+{
+	if (!m_bBuilt)
+		return;
+
+	for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+		if (it->first == idRecord)
+		{
+			m_entries.erase(std::next(it).base());
+			m_pPayload.reset();
+			return;
+		}
+}
+
+LogCache::StringPtr LogCache::GetPayload() const
+{
+	VERIFY_MODEL(m_bBuilt);
+	if (!m_pPayload)
+	{
+		int idCursor = 0;
+		Vec page = GetPage(0, idCursor);
+		m_pPayload = std::make_shared<std::string>(Output::AddLog(page, idCursor).GetXML());
+	}
+	return m_pPayload;
+}
+
+LogCache::Vec LogCache::GetPage(int idBefore, int& idCursor) const
+{
+	VERIFY_MODEL(m_bBuilt);
+
+	auto end = idBefore ? std::lower_bound(m_entries.begin(), m_entries.end(), idBefore, 
+		[](const Vec::value_type& entry, int id) { return entry.first < id; }) : m_entries.end();
+	auto begin = end - std::min<ptrdiff_t>(PageSize, end - m_entries.begin());
+
+	idCursor = begin == m_entries.begin() ? 0 : begin->first;
+	return Vec(begin, end);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class LiveGame;
+
+// The messages of a LiveGame's records, kept in step with the record stack so a full update needn't regenerate them.
+// Full updates only send the last page; the client fetches earlier pages on demand.
+// The serialised AddLog payload is built once and shared by every update until the log next changes.
+class LogCache
+{
+public:
+	typedef std::vector<std::pair<int, std::string>> Vec;
+	typedef std::shared_ptr<std::string> StringPtr;
+
+	LogCache();
+
+	bool IsBuilt() const { return m_bBuilt; }
+	void Build(const LiveGame& game); // From the records' current messages, after loading.
+
+	void Add(int idRecord, const std::string& msg);
+	void Remove(int idRecord);
+
+	const Vec& GetEntries() const { return m_entries; }
+	StringPtr GetPayload() const; // Last page.
+
+	// Up to PageSize entries before idBefore (or the last page if 0). Record IDs only increase, so they make stable cursors.
+	// idCursor: the first returned ID if there are earlier entries, otherwise 0.
+	Vec GetPage(int idBefore, int& idCursor) const;
+
+	static const int PageSize;
+
+private:
+	Vec m_entries;
+	bool m_bBuilt;
+	mutable StringPtr m_pPayload;
+};
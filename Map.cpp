@@ -5,14 +5,32 @@
 #include "App.h"
 #include "EdgeSet.h"
 
-Map::Map(Game& game) : m_game(game)
+Map::Map(Game& game) : m_game(game), m_hash(0), m_version(1)
 {
 }
 
-Map::Map(const Map& rhs, Game& game) : m_game(game)
+// Hexes are shared with rhs until either map writes to them.
+Map::Map(const Map& rhs, Game& game) : m_game(game), m_hexes(rhs.m_hexes), m_hash(rhs.m_hash), m_version(rhs.m_version)
 {
-	for (auto& h : rhs.m_hexes)
-		m_hexes.insert(std::make_pair(h.first, HexPtr(new Hex(*h.second))));
+}
+
+// Like the copy constructor, but keeps our game.
+// Bumps the version without any dirty hexes, so clients that miss the following full update will fetch it.
+void Map::Restore(const Map& rhs)
+{
+	m_hexes = rhs.m_hexes;
+	m_hash = rhs.m_hash;
+	m_dirty.clear();
+	++m_version;
+}
+
+std::set<MapPos> Map::TakeDirty()
+{
+	std::set<MapPos> dirty;
+	dirty.swap(m_dirty);
+	if (!dirty.empty())
+		++m_version;
+	return dirty;
 }
 
 bool Map::operator==(const Map& rhs) const
@@ -20,7 +38,34 @@ bool Map::operator==(const Map& rhs) const
 	return ArePtrMapsEqual(m_hexes, rhs.m_hexes);
 }
 
+uint64_t Map::ComputeHash() const
+{
+	uint64_t hash = 0;
+	for (auto& h : m_hexes)
+		hash ^= h.second->GetHash();
+	return hash;
+}
+
+// The hash pointer is reattached every time, since the previous sharer may have been the last to attach it.
+// Called for all non-const access, so also marks the hex dirty. 
+Hex& Map::Unshare(SharedHexPtr& hex)
+{
+	m_dirty.insert(hex->GetPos());
+	if (hex.use_count() > 1)
+		hex = std::make_shared<Hex>(*hex);
+	hex->AttachHash(&m_hash);
+	return *hex;
+}
+
 Hex* Map::FindHex(int hexId) 
+{
+	for (auto& h : m_hexes)
+		if (h.second->GetID() == hexId)
+			return &Unshare(h.second);
+	return nullptr;
+}
+
+const Hex* Map::FindHex(int hexId) const
 {
 	for (auto& h : m_hexes)
 		if (h.second->GetID() == hexId)
@@ -29,6 +74,12 @@ Hex* Map::FindHex(int hexId)
 }
 
 Hex* Map::FindHex(const MapPos& pos)
+{
+	auto h = m_hexes.find(pos);
+	return h == m_hexes.end() ? nullptr : &Unshare(h->second);
+}
+
+const Hex* Map::FindHex(const MapPos& pos) const
 {
 	auto h = m_hexes.find(pos);
 	return h == m_hexes.end() ? nullptr : h->second.get();
@@ -63,6 +114,13 @@ Hex& Map::GetHex(const MapPos& pos)
 	return *pHex;
 }
 
+const Hex& Map::GetHex(const MapPos& pos) const
+{
+	const Hex* pHex = FindHex(pos);
+	VERIFY_MODEL(!!pHex);
+	return *pHex;
+}
+
 std::vector<MapPos> Map::GetOwnedHexPositions(const Team& team) const
 {
 	std::vector<MapPos> result;
@@ -104,8 +162,11 @@ Map::StartPositions Map::GetTeamStartPositions() const
 Hex& Map::AddHex(HexPtr hex)
 {
 	Hex& hex2 = *hex;
-	VERIFY_MODEL_MSG("hex already occupied", FindHex(hex->GetPos()) == nullptr);
-	m_hexes.insert(std::make_pair(hex->GetPos(), std::move(hex)));
+	VERIFY_MODEL_MSG("hex already occupied", m_hexes.find(hex->GetPos()) == m_hexes.end());
+	m_hexes.insert(std::make_pair(hex->GetPos(), SharedHexPtr(std::move(hex))));
+	m_hash ^= hex2.GetHash();
+	hex2.AttachHash(&m_hash);
+	m_dirty.insert(hex2.GetPos());
 	return hex2;
 }
 
@@ -113,6 +174,8 @@ void Map::DeleteHex(const MapPos& pos)
 {
 	auto i = m_hexes.find(pos);
 	VERIFY_MODEL_MSG("hex not found", i != m_hexes.end());
+	m_hash ^= i->second->GetHash();
+	m_dirty.insert(pos); // Before pos can dangle.
 	m_hexes.erase(i);
 }
 
@@ -235,5 +298,9 @@ void Map::Load(const Serial::LoadNode& node)
 	node.LoadMap("hexes", m_hexes, Serial::TypeLoader(), Serial::ClassPtrLoader());
 
 	for (auto& kv : m_hexes)
+	{
 		kv.second->SetPos(kv.first);
+		kv.second->AttachHash(&m_hash);
+	}
+	m_hash = ComputeHash();
 }
@@ -18,9 +18,20 @@ class Map
 public:
 	Map(Game& game);
 	Map(const Map& rhs, Game& game);
+	void Restore(const Map& rhs);
 
 	bool operator==(const Map& rhs) const;
 
+	uint64_t GetHash() const { return m_hash; } // Maintained incrementally by the hexes.
+	uint64_t ComputeHash() const;
+
+	// Clients apply map deltas to the version they have, and fetch the whole map if it doesn't match. 
+	// Not saved: clients always get the whole map when they connect.
+	int GetVersion() const { return m_version; }
+	std::set<MapPos> TakeDirty(); // Hexes added, deleted or written to since the last call. Bumps the version.
+	const std::set<MapPos>& GetDirty() const { return m_dirty; }
+	void SetDirty(const std::set<MapPos>& dirty) { m_dirty = dirty; } // For writes that leave the hexes as they were.
+
 	Hex& AddHex(HexPtr hex);
 	void DeleteHex(const MapPos& pos);
 	
@@ -29,19 +40,44 @@ public:
 	
 	Game& GetGame() { return m_game; }
 
-	typedef std::map<MapPos, HexPtr> HexMap;
-	const HexMap& GetHexes() const { return m_hexes; }
+	typedef std::shared_ptr<Hex> SharedHexPtr; // Shared between copies until written to.
+	typedef std::map<MapPos, SharedHexPtr> HexMap;
+
+	// Read-only, so writes have to go through GetHex, which unshares. Yields (pos, const Hex*) pairs.
+	class HexIter
+	{
+	public:
+		HexIter(HexMap::const_iterator it) : m_it(it) {}
+		bool operator !=(const HexIter& rhs) const { return m_it != rhs.m_it; }
+		std::pair<const MapPos&, const Hex*> operator* () const { return { m_it->first, m_it->second.get() }; }
+		void operator++ () { ++m_it; }
+	private:
+		HexMap::const_iterator m_it;
+	};
+
+	class HexRange
+	{
+	public:
+		HexRange(const HexMap& hexes) : m_hexes(hexes) {}
+		HexIter begin() const { return HexIter(m_hexes.begin()); }
+		HexIter end() const { return HexIter(m_hexes.end()); }
+	private:
+		const HexMap& m_hexes;
+	};
+
+	HexRange GetHexes() const { return HexRange(m_hexes); }
 
 	std::vector<MapPos> GetOwnedHexPositions(const Team& team) const;
 
+	// Non-const access unshares the hex.
 	Hex& GetHex(const MapPos& pos);
 	Hex* FindHex(const MapPos& pos);
 	
-	const Hex& GetHex(const MapPos& pos) const { return const_cast<Map*>(this)->GetHex(pos); }
-	const Hex* FindHex(const MapPos& pos) const { return const_cast<Map*>(this)->FindHex(pos); }
+	const Hex& GetHex(const MapPos& pos) const;
+	const Hex* FindHex(const MapPos& pos) const;
 	
 	Hex* FindHex(int hexId);
-	const Hex* FindHex(int hexId) const { return const_cast<Map*>(this)->FindHex(hexId); }
+	const Hex* FindHex(int hexId) const;
 	const Hex* FindPendingBattleHex(const Game& game, int lastHex) const;
 	bool HasPendingBattle(const Game& game) const;
 
@@ -59,6 +95,11 @@ public:
 	void Load(const Serial::LoadNode& node);
 
 private:
+	Hex& Unshare(SharedHexPtr& hex);
+
 	HexMap m_hexes;
 	Game& m_game;
+	uint64_t m_hash;
+	std::set<MapPos> m_dirty;
+	int m_version;
 };
@@ -4,6 +4,7 @@
 #include "civetweb.h"
 #include "Util.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
@@ -23,7 +24,11 @@ static void websocket_ready_handler(mg_connection *conn);
 static int websocket_data_handler(mg_connection *conn, int flags, char *data, size_t data_len);
 static int log_message(const struct mg_connection*, const char *message);
 
-MongooseServer::MongooseServer(int port)
+const size_t MongooseServer::MaxOutboxBytes = 8 << 20; // A client this far behind is disconnected, and resyncs when it reconnects.
+const int MongooseServer::WriterThreadCount = 4;
+const size_t MongooseServer::DeflateThreshold = 512; // Smaller messages aren't worth it.
+
+MongooseServer::MongooseServer(int port) : m_bStopWriters(false)
 {
 	std::string portStr = ::FormatInt(port);
 	if (::UseSSL)
@@ -59,51 +64,186 @@ MongooseServer::MongooseServer(int port)
 
 	if (!m_pContext)
 		throw std::runtime_error(__func__);
+
+	for (int i = 0; i < WriterThreadCount; ++i)
+		m_writers.push_back(std::thread(&MongooseServer::WriterThread, this));
 }
 	
+// Writers first, so none is writing while mg_stop closes the connections.
 MongooseServer::~MongooseServer()
 {
+	{
+		LOCK(m_mutex);
+		m_bStopWriters = true;
+	}
+	m_writerCV.notify_all();
+	for (auto& writer : m_writers)
+		writer.join();
+
 	mg_stop(m_pContext);
 }
 
 void MongooseServer::RegisterClient(ClientID client, mg_connection* pConn)
 {
 	LOCK(m_mutex);
-	ASSERT(m_mapPortToConn.insert(std::make_pair(client, pConn)).second);
+	ASSERT(m_clients.insert(std::make_pair(client, Client(pConn))).second);
+	m_connections[pConn] = Connection();
+}
+
+void MongooseServer::OnConnectionClosed(mg_connection* pConn)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	auto it = m_connections.find(pConn);
+	if (it == m_connections.end())
+		return; // Not a websocket.
+
+	it->second.bClosed = true;
+	m_writeDoneCV.wait(lock, [&] { return it->second.nWriting == 0; });
+	m_connections.erase(it);
+
+	m_setAbortConns.erase(pConn);
+	m_abortPings.erase(std::remove(m_abortPings.begin(), m_abortPings.end(), pConn), m_abortPings.end());
+}
+
+bool MongooseServer::BeginWrite(mg_connection* pConn)
+{
+	auto it = m_connections.find(pConn);
+	if (it == m_connections.end() || it->second.bClosed)
+		return false;
+
+	++it->second.nWriting;
+	return true;
+}
+
+void MongooseServer::EndWrite(mg_connection* pConn)
+{
+	auto it = m_connections.find(pConn);
+	ASSERT(it != m_connections.end()); // The close handler waits for us.
+	if (--it->second.nWriting == 0 && it->second.bClosed)
+		m_writeDoneCV.notify_all();
 }
 
 bool MongooseServer::UnregisterClient(ClientID client, bool bAbort)
 {
 	LOCK(m_mutex);
 
-	auto it = m_mapPortToConn.find(client);
-	if (it == m_mapPortToConn.end())
+	auto it = m_clients.find(client);
+	if (it == m_clients.end())
 		return false;
 	
 	if (bAbort)
-	{
-		// Looks like mg_close_connection isn't thread safe. 
-		m_setAbortConns.insert(it->second);
-		mg_websocket_write(it->second, WEBSOCKET_OPCODE_PING, nullptr, 0); // Pong will force instant disconnect.
-	}
+		AbortConnection(it->second.pConn);
 
-	m_mapPortToConn.erase(it);
+	m_clients.erase(it); // Unsent messages are dropped.
 	return true;
 }
 
+// Call with m_mutex locked. 
+void MongooseServer::AbortConnection(mg_connection* pConn) const
+{
+	// Looks like mg_close_connection isn't thread safe. 
+	m_setAbortConns.insert(pConn);
+	m_abortPings.push_back(pConn); // Pong will force instant disconnect.
+	m_writerCV.notify_one();
+}
+
 bool MongooseServer::PopAbort(mg_connection* pConn)
 {
 	LOCK(m_mutex);
 	return m_setAbortConns.erase(pConn) > 0;
 }
 
-mg_connection* MongooseServer::FindConnection(ClientID client) const
+void MongooseServer::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_writerCV.wait(lock, [&] { return m_bStopWriters || !m_readyClients.empty() || !m_abortPings.empty(); });
+		if (m_bStopWriters)
+			return;
+
+		if (!m_abortPings.empty())
+		{
+			mg_connection* pConn = m_abortPings.front();
+			m_abortPings.pop_front();
+			if (BeginWrite(pConn))
+			{
+				lock.unlock();
+				mg_websocket_write(pConn, WEBSOCKET_OPCODE_PING, nullptr, 0);
+				lock.lock();
+				EndWrite(pConn);
+			}
+			continue;
+		}
+
+		ClientID client = m_readyClients.front();
+		m_readyClients.pop_front();
+
+		// Look the client up each time, since it may be unregistered while we write.
+		for (auto it = m_clients.find(client); it != m_clients.end() && !it->second.outbox.empty(); it = m_clients.find(client))
+		{
+			std::string msg = std::move(it->second.outbox.front().first);
+			bool bBinary = it->second.outbox.front().second;
+			it->second.outbox.pop_front();
+			it->second.outboxBytes -= msg.size();
+			mg_connection* pConn = it->second.pConn;
+			std::shared_ptr<Deflater> pDeflater = it->second.pDeflater;
+
+			if (!BeginWrite(pConn))
+				break; // Closed.
+
+			lock.unlock();
+			if (pDeflater && msg.size() >= DeflateThreshold)
+				CompressMessage(*pDeflater, msg, bBinary);
+			const int opcode = bBinary ? WEBSOCKET_OPCODE_BINARY : WEBSOCKET_OPCODE_TEXT;
+			bool bOK = mg_websocket_write(pConn, opcode, msg.c_str(), msg.size()) == msg.size();
+			lock.lock();
+			EndWrite(pConn);
+
+			if (!bOK)
+				break; // Closing: the close handler will unregister it.
+		}
+
+		auto it = m_clients.find(client);
+		if (it != m_clients.end())
+		{
+			it->second.bWriting = false;
+			it->second.outbox.clear();
+			it->second.outboxBytes = 0;
+		}
+	}
+}
+
+// Compressed messages are binary: 0xfe (text) or 0xff (binary), the uncompressed size as a varint, then the deflated message. 
+// Neither byte can start a JSON or BinaryCodec message.
+void MongooseServer::CompressMessage(Deflater& deflater, std::string& msg, bool& bBinary)
+{
+	std::string header(1, bBinary ? '\xff' : '\xfe');
+	for (size_t n = msg.size(); ; n >>= 7)
+	{
+		header += char(n >= 0x80 ? (n & 0x7f) | 0x80 : n);
+		if (n < 0x80)
+			break;
+	}
+
+	msg = header + deflater.Compress(msg);
+	bBinary = true;
+}
+
+bool MongooseServer::EnableDeflate(ClientID client)
 {
+	if (!Deflater::IsAvailable())
+		return false;
+
 	LOCK(m_mutex);
-	auto it = m_mapPortToConn.find(client);
-	if (it != m_mapPortToConn.end())
-		return it->second;
-	return nullptr;
+	auto it = m_clients.find(client);
+	if (it == m_clients.end())
+		return false;
+
+	if (!it->second.pDeflater)
+		it->second.pDeflater = std::make_shared<Deflater>();
+	return true;
 }
 
 std::string MongooseServer::GetWebSocketScheme() const
@@ -111,13 +251,34 @@ std::string MongooseServer::GetWebSocketScheme() const
 	return ::UseSSL ? "wss" : "ws";
 }
 
-bool MongooseServer::SendMessage(ClientID client, const std::string& msg) const
+bool MongooseServer::SendMessage(ClientID client, const std::string& msg, bool bBinary) const
 {
-	auto pConn = FindConnection(client);
-	if (!pConn)
+	LOCK(m_mutex);
+
+	auto it = m_clients.find(client);
+	if (it == m_clients.end() || m_setAbortConns.count(it->second.pConn))
 		return false;
 
-	return mg_websocket_write(pConn, WEBSOCKET_OPCODE_TEXT, msg.c_str(), msg.size()) == msg.size();
+	Client& c = it->second;
+	if (c.outboxBytes + msg.size() > MaxOutboxBytes)
+	{
+		std::cerr << "WARNING: Disconnecting client " << client << ": " << c.outbox.size() << " messages unsent" << std::endl;
+		c.outbox.clear();
+		c.outboxBytes = 0;
+		AbortConnection(c.pConn);
+		return false;
+	}
+
+	c.outbox.push_back(std::make_pair(msg, bBinary));
+	c.outboxBytes += msg.size();
+
+	if (!c.bWriting)
+	{
+		c.bWriting = true;
+		m_readyClients.push_back(client);
+		m_writerCV.notify_one();
+	}
+	return true;
 }
 
 std::string MongooseServer::CreateOKResponse(const std::string& content, const Cookies& cookies)
@@ -142,6 +303,27 @@ std::string MongooseServer::CreateRedirectResponse(const std::string& url, const
 		url, cookies);
 }
 
+std::string MongooseServer::CreateContentResponse(const std::string& content, const std::string& contentType, const std::string& headers)
+{
+	std::string response = ::FormatString(
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: %0\r\n"
+		"Content-Length: %1\r\n"
+		"%2"
+		"\r\n",
+		contentType, content.size(), headers);
+	return response + content;
+}
+
+std::string MongooseServer::CreateNotModifiedResponse(const std::string& etag)
+{
+	return ::FormatString(
+		"HTTP/1.1 304 Not Modified\r\n"
+		"ETag: %0\r\n"
+		"\r\n",
+		etag);
+}
+
 std::string MongooseServer::CreateMD5(const std::string& string1, const std::string& string2)
 {
 	char buf[33];
@@ -181,6 +363,15 @@ public:
 		}
 		return postData;
 	}
+	virtual std::string GetHeader(const std::string& name) const override
+	{
+		const char* value = mg_get_header(m_conn, name.c_str());
+		return value ? value : "";
+	}
+	virtual std::string GetRemoteAddress() const override
+	{
+		return mg_get_request_info(m_conn)->remote_addr;
+	}
 private:
 	mg_connection* m_conn;
 };
@@ -210,6 +401,8 @@ void connection_close_handler(const mg_connection *conn)
 	MongooseServer* pServer = reinterpret_cast<MongooseServer*>(request_info->user_data);
 	const ClientID client = reinterpret_cast<ClientID>(conn);
 
+	pServer->OnConnectionClosed(const_cast<mg_connection*>(conn));
+
 	if (pServer->UnregisterClient(client))
 		pServer->OnWebSocketDisconnect(client);
 }
@@ -248,8 +441,9 @@ int websocket_data_handler(mg_connection *conn, int flags, char *data, size_t da
 		switch (flags)
 		{
 		case WEBSOCKET_OPCODE_TEXT:
+		case WEBSOCKET_OPCODE_BINARY:
 			if (data_len)
-				pServer->OnWebSocketMessage(client, std::string(data, data_len));
+				pServer->OnWebSocketMessage(client, std::string(data, data_len), flags == WEBSOCKET_OPCODE_BINARY);
 			break;
 		case WEBSOCKET_OPCODE_CONNECTION_CLOSE: // Called on refresh but not tab/browser close.
 			pServer->UnregisterClient(client);
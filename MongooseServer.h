@@ -1,6 +1,11 @@
 #pragma once
 
 #include "App.h"
+#include "Deflater.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 typedef unsigned long long ClientID;
 
@@ -33,6 +38,8 @@ public:
 		virtual StringMap GetQueries() const = 0;
 		virtual StringMap GetCookies() const = 0;
 		virtual StringMap GetPostData() const = 0;
+		virtual std::string GetHeader(const std::string& name) const = 0;
+		virtual std::string GetRemoteAddress() const = 0;
 	};
 
 	virtual ~IServer() {}
@@ -40,7 +47,7 @@ public:
 	virtual bool OnWebSocketConnect(const std::string& url, const StringMap& cookies) { return true; }
 	virtual void OnWebSocketReady(ClientID client, const std::string& url) {}
 	virtual void OnWebSocketDisconnect(ClientID client) {}
-	virtual void OnWebSocketMessage(ClientID client, const std::string& msg) {}
+	virtual void OnWebSocketMessage(ClientID client, const std::string& msg, bool bBinary) {}
 
 	static StringMap SplitString(const std::string& string, char sep);
 };
@@ -56,11 +63,15 @@ public:
 
 	void RegisterClient(ClientID client, mg_connection* pConn);
 	bool UnregisterClient(ClientID client, bool bAbort = false);
-	bool SendMessage(ClientID client, const std::string& msg) const;
+	bool SendMessage(ClientID client, const std::string& msg, bool bBinary = false) const; // Queued for a writer thread. Returns false if the client is gone.
+	bool EnableDeflate(ClientID client); // For messages queued from now on. False if not built with zlib.
 	bool PopAbort(mg_connection* pConn);
+	void OnConnectionClosed(mg_connection* pConn); // Returns once no writer is using it. It's never written to again.
 	
 	static std::string CreateOKResponse(const std::string& content, const Cookies& cookies = Cookies());
 	static std::string CreateRedirectResponse(const std::string& newUrl, const Cookies& cookies = Cookies());
+	static std::string CreateContentResponse(const std::string& content, const std::string& contentType, const std::string& headers); // Binary safe.
+	static std::string CreateNotModifiedResponse(const std::string& etag);
 
 	static std::string CreateMD5(const std::string& string1, const std::string& string2);
 
@@ -68,10 +79,44 @@ protected:
 	std::string GetWebSocketScheme() const;
 
 private:
-	mg_connection* FindConnection(ClientID client) const;
+	// Outgoing messages wait here so that a slow client only holds up a writer thread, never message processing. 
+	struct Client
+	{
+		Client(mg_connection* conn) : pConn(conn), outboxBytes(0), bWriting(false) {}
+		mg_connection* pConn;
+		std::deque<std::pair<std::string, bool>> outbox; // Message, binary.
+		size_t outboxBytes;
+		bool bWriting; // Owned by a writer thread, which keeps its messages in order.
+		std::shared_ptr<Deflater> pDeflater; // Only used by the writing thread.
+	};
+
+	// Open websocket connections. civetweb frees a connection once its close handler returns.
+	struct Connection
+	{
+		Connection() : nWriting(0), bClosed(false) {}
+		int nWriting; // Writers inside mg_websocket_write.
+		bool bClosed;
+	};
+
+	void AbortConnection(mg_connection* pConn) const;
+	bool BeginWrite(mg_connection* pConn); // Call with m_mutex locked. False if it's closed.
+	void EndWrite(mg_connection* pConn); // Call with m_mutex locked.
+	void WriterThread();
+	static void CompressMessage(Deflater& deflater, std::string& msg, bool& bBinary);
+
+	static const size_t MaxOutboxBytes;
+	static const size_t DeflateThreshold;
+	static const int WriterThreadCount;
 
 	mg_context* m_pContext;
 	mutable std::mutex m_mutex;
-	std::map<ClientID, mg_connection*> m_mapPortToConn;
-	std::set<mg_connection*> m_setAbortConns;
+	mutable std::map<ClientID, Client> m_clients;
+	mutable std::set<mg_connection*> m_setAbortConns;
+	mutable std::deque<ClientID> m_readyClients; // Have messages and no writer.
+	mutable std::deque<mg_connection*> m_abortPings;
+	mutable std::condition_variable m_writerCV;
+	std::map<mg_connection*, Connection> m_connections;
+	std::condition_variable m_writeDoneCV;
+	std::vector<std::thread> m_writers;
+	bool m_bStopWriters;
 };
@@ -22,7 +22,7 @@ void MoveCmd::UpdateClient(const Controller& controller, const LiveGame& game) c
 	std::map<MapPos, std::set<ShipType>> srcs;
 
 	// Get movable ships in each hex.
-	for (auto& h : game.GetMap().GetHexes()) // Pos, hex.
+	for (auto h : game.GetMap().GetHexes()) // Pos, hex.
 		if (CanMoveFrom(*h.second, game))
 			if (auto* fleet = h.second->FindFleet(m_colour))
 				for (auto& squadron : fleet->GetSquadrons())
@@ -99,7 +99,7 @@ private:
 
 	virtual void Update(const Game& game, const Team& team, const RecordContext& context) const override
 	{
-		context.SendMessage(Output::UpdateMap(context.GetGame()));
+		context.SendMapDelta();
 	}
 	
 	virtual std::string GetTeamMessage() const
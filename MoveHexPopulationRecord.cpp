@@ -48,5 +48,5 @@ void MoveHexPopulationRecord::Apply(bool bDo, const Game& game, const Team& team
 void MoveHexPopulationRecord::Update(const Game& game, const Team& team, const RecordContext& context) const
 {
 	__super::Update(game, team, context);
-	context.SendMessage(Output::UpdateMap(context.GetGame()));
+	context.SendMapDelta();
 }
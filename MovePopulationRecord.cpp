@@ -25,5 +25,5 @@ void MovePopulationRecord::Load(const Serial::LoadNode& node)
 
 void MovePopulationRecord::Update(const Game& game, const Team& team, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdatePopulationTrack(team));
+	context.SendSharedMessage<Output::UpdatePopulationTrack>(::EnumToString(team.GetColour()), team);
 }
@@ -7,32 +7,79 @@
 #include "Technology.h"
 #include "LiveGame.h"
 #include "ReviewGame.h"
-#include "Games.h"
 #include "ActionPhase.h"
 #include "Battle.h"
 #include "CombatPhase.h"
 #include "Dice.h"
 
+#include <cstring>
+
 namespace
 {
-	void AddPlayers(const Game& game, Json::Element& root)
+	void AddPlayers(const Game& game, JsonWriter::Element& root)
 	{
 		auto playersNode = root.AddArray("players");
 		for (auto& i : game.GetTeams())
 			playersNode.Append(i->GetPlayer().GetName());
 	}
-	void AddPointElement(int x, int y, const std::string& name, Json::Element& root)
+	void AddPointElement(int x, int y, const char* name, JsonWriter::Element& root)
 	{
 		auto node = root.AddElement(name);
 		node.SetAttribute("x", x);
 		node.SetAttribute("y", y);
 	}
-	void AppendPointElement(int x, int y, Json::Array& array)
+	void AddLogItems(const std::vector<std::pair<int, std::string>>& msgs, JsonWriter::Element& root)
+	{
+		auto msgsNode = root.AddArray("items");
+		for (auto& msg : msgs)
+		{
+			auto msgNode = msgsNode.AppendElement();
+			msgNode.SetAttribute("id", msg.first);
+			msgNode.SetAttribute("message", msg.second);
+		}
+	}
+	void AppendPointElement(int x, int y, JsonWriter::Array& array)
 	{
 		auto node = array.AppendElement();
 		node.SetAttribute("x", x);
 		node.SetAttribute("y", y);
 	}
+	void AppendHex(const Game& game, const MapPos& pos, const Hex& hex, JsonWriter::Array& hexesNode)
+	{
+		auto e = hexesNode.AppendElement();
+		e.SetAttribute("x", pos.GetX());
+		e.SetAttribute("y", pos.GetY());
+		e.SetAttribute("id", hex.GetID());
+		e.SetAttribute("rotation", hex.GetRotation());
+
+		if (hex.IsOwned())
+		{
+			const Team& team = game.GetTeam(hex.GetColour());
+			e.SetAttribute("colour", ::EnumToString(team.GetColour()));
+		
+			auto eSquares = e.AddArray("squares");
+			for (auto& square : hex.GetSquares())
+				if (square.IsOccupied())
+				{
+					auto eSquare = eSquares.AppendElement();
+					eSquare.SetAttribute("x", square.GetX());
+					eSquare.SetAttribute("y", square.GetY());
+				}
+		}
+
+		auto eShips = e.AddArray("ships");
+		for (auto& fleet : hex.GetFleets())
+			for (auto& squadron : fleet.GetSquadrons())
+			{
+				auto eShip = eShips.AppendElement();
+				eShip.SetAttribute("colour", ::EnumToString(fleet.GetColour()));
+				eShip.SetAttribute("type", ::EnumToString(squadron.GetType()));
+				eShip.SetAttribute("count", squadron.GetShipCount());
+			}
+
+		//DiscoveryType GetDiscoveryTile() const { return m_discovery; }
+		//int GetVictoryPoints() const { return m_nVictory; }
+	}
 }
 
 namespace Output
@@ -40,19 +87,19 @@ namespace Output
 
 std::string Message::GetXML() const
 {
-	return m_doc.SaveToString();
+	return m_writer.GetString();
 }
 
 //--------------------------------------------
 
 Response::Response()
 {
-	m_root = m_doc.AddElement("response");
+	m_root = m_writer.GetDocument().AddElement("response");
 }
 
 Command::Command(const std::string& cmd) 
 {
-	m_root = m_doc.AddElement("command");
+	m_root = m_writer.GetDocument().AddElement("command");
 	m_root.SetAttribute("type", cmd);
 }
 
@@ -71,28 +118,41 @@ Choose::Choose(const std::string& param) : Command("choose")
 	m_root.SetAttribute("param", param);
 }
 
-UpdateGameList::UpdateGameList(const Player& player) : Update("game_list")
+UpdateSession::UpdateSession(int epoch) : Update("session")
+{
+	m_root.SetAttribute("epoch", epoch);
+}
+
+UpdateCodec::UpdateCodec(const std::vector<std::string>& words) : Update("codec")
+{
+	auto wordsNode = m_root.AddArray("words");
+	for (auto& word : words)
+		wordsNode.Append(word);
+}
+
+UpdateGameList::UpdateGameList(const std::vector<GameDirectory::EntryPtr>& entries, const Player& player) : Update("game_list")
 {
-	auto mine = m_root.AddArray("mine");
-	auto open = m_root.AddArray("open");
-	auto other = m_root.AddArray("other");
+	std::vector<const char*> groups;
+	groups.reserve(entries.size());
+	for (auto& pEntry : entries)
+		groups.push_back(pEntry->GetGroup(player));
 
-	for (auto& g : Games::GetLiveGames())
+	// One array at a time, for the writer.
+	for (const char* group : { "mine", "open", "other" })
 	{
-		auto& node =
-			g->FindTeam(player) ? mine :
-			g->HasStarted() ? other :
-			open;
-		
-		auto gameNode = node.AppendElement();
-		gameNode.SetAttribute("name", g->GetName());
-		gameNode.SetAttribute("id", g->GetID());
-		gameNode.SetAttribute("owner", g->GetOwner().GetName());
-	
-		AddPlayers(*g, gameNode);
+		auto node = m_root.AddArray(group);
+		for (size_t i = 0; i < entries.size(); ++i)
+			if (std::strcmp(groups[i], group) == 0)
+				node.AppendRaw(entries[i]->json);
 	}
 }
 
+UpdateGameListEntry::UpdateGameListEntry(const GameDirectory::Entry& entry, bool bMine) : Update("game_list_entry")
+{
+	m_root.SetAttribute("group", entry.GetGroup(bMine));
+	m_root.SetRawAttribute("game", entry.json);
+}
+
 UpdateLobby::UpdateLobby(const Game& game) : Update("lobby")
 {
 	m_root.SetAttribute("owner", game.GetOwner().GetName());
@@ -244,52 +304,32 @@ UpdateBlueprints::UpdateBlueprints(const Team& team) : Update("blueprints")
 	}
 }
 
-
 UpdateMap::UpdateMap(const Game& game) : Update("map")
 {
 	const Map& map = game.GetMap();
-	auto& hexes = map.GetHexes();
+	m_root.SetAttribute("version", map.GetVersion());
 
 	auto hexesNode = m_root.AddArray("hexes");
-	for (auto& i : hexes)
-	{
-		const MapPos& pos = i.first;
-		const Hex& hex = *i.second.get();
-
-		auto e = hexesNode.AppendElement();
-		e.SetAttribute("x", pos.GetX());
-		e.SetAttribute("y", pos.GetY());
-		e.SetAttribute("id", hex.GetID());
-		e.SetAttribute("rotation", hex.GetRotation());
+	for (auto i : map.GetHexes())
+		AppendHex(game, i.first, *i.second, hexesNode);
+}
 
-		if (hex.IsOwned())
-		{
-			const Team& team = game.GetTeam(hex.GetColour());
-			e.SetAttribute("colour", ::EnumToString(team.GetColour()));
-		
-			auto eSquares = e.AddArray("squares");
-			for (auto& square : hex.GetSquares())
-				if (square.IsOccupied())
-				{
-					auto eSquare = eSquares.AppendElement();
-					eSquare.SetAttribute("x", square.GetX());
-					eSquare.SetAttribute("y", square.GetY());
-				}
-		}
+// Clients at baseVersion replace the hexes at positions, and delete any that aren't included.
+UpdateMapDelta::UpdateMapDelta(const Game& game, const std::set<MapPos>& positions, int baseVersion) : Update("map_delta")
+{
+	const Map& map = game.GetMap();
+	m_root.SetAttribute("base_version", baseVersion);
+	m_root.SetAttribute("version", map.GetVersion());
 
-		auto eShips = e.AddArray("ships");
-		for (auto& fleet : hex.GetFleets())
-			for (auto& squadron : fleet.GetSquadrons())
-			{
-				auto eShip = eShips.AppendElement();
-				eShip.SetAttribute("colour", ::EnumToString(fleet.GetColour()));
-				eShip.SetAttribute("type", ::EnumToString(squadron.GetType()));
-				eShip.SetAttribute("count", squadron.GetShipCount());
-			}
+	auto hexesNode = m_root.AddArray("hexes");
+	for (auto& pos : positions)
+		if (const Hex* pHex = map.FindHex(pos))
+			AppendHex(game, pos, *pHex, hexesNode);
 
-		//DiscoveryType GetDiscoveryTile() const { return m_discovery; }
-		//int GetVictoryPoints() const { return m_nVictory; }
-	}
+	auto removedNode = m_root.AddArray("removed");
+	for (auto& pos : positions)
+		if (!map.FindHex(pos))
+			AppendPointElement(pos.GetX(), pos.GetY(), removedNode);
 }
 
 UpdateReviewUI::UpdateReviewUI(const ReviewGame& game) : Update("review_ui")
@@ -297,6 +337,8 @@ UpdateReviewUI::UpdateReviewUI(const ReviewGame& game) : Update("review_ui")
 	m_root.SetAttribute("can_advance", game.CanAdvance());
 	m_root.SetAttribute("can_retreat", game.CanRetreat());
 	m_root.SetAttribute("next_record_id", game.GetNextRecordID());
+	m_root.SetAttribute("round", game.GetRound());
+	m_root.SetAttribute("round_count", game.GetRoundCount());
 }
 
 UpdateTechnologies::UpdateTechnologies(const Game& game) : Update("technologies")
@@ -328,22 +370,25 @@ UpdateCombat::UpdateCombat(const Game& game, const Battle& battle) : Update("com
 {
 	const Battle::Group& currentGroup = battle.GetCurrentGroup();
 
-	Json::Element elems[] = { m_root.AddElement("defender"), m_root.AddElement("invader") };
-	Json::Array groupsElems[] = { elems[0].AddArray("ship_groups"), elems[1].AddArray("ship_groups") };
-
+	// One side at a time, for the writer.
 	for (int invader = 0; invader < 2; ++invader)
-		elems[invader].SetAttribute("colour", ::EnumToString(battle.GetColour(!!invader)));
-
-	for (auto& group : battle.GetGroups())
 	{
-		auto groupElem = groupsElems[group.invader].AppendElement();
-		groupElem.SetAttribute("type", ::EnumToString(group.shipType));
-		groupElem.SetAttribute("max_lives", battle.GetBlueprint(game, group).GetLives());
-		groupElem.SetAttribute("active", group.invader == currentGroup.invader && group.shipType == currentGroup.shipType);
-
-		auto shipsElem = groupElem.AddArray("ships");
-		for (auto& lives : group.lifeCounts)
-			shipsElem.Append(lives);
+		auto elem = m_root.AddElement(invader ? "invader" : "defender");
+		elem.SetAttribute("colour", ::EnumToString(battle.GetColour(!!invader)));
+
+		auto groupsElem = elem.AddArray("ship_groups");
+		for (auto& group : battle.GetGroups())
+			if (group.invader == !!invader)
+			{
+				auto groupElem = groupsElem.AppendElement();
+				groupElem.SetAttribute("type", ::EnumToString(group.shipType));
+				groupElem.SetAttribute("max_lives", battle.GetBlueprint(game, group).GetLives());
+				groupElem.SetAttribute("active", group.invader == currentGroup.invader && group.shipType == currentGroup.shipType);
+
+				auto shipsElem = groupElem.AddArray("ships");
+				for (auto& lives : group.lifeCounts)
+					shipsElem.Append(lives);
+			}
 	}
 }
 
@@ -389,15 +434,17 @@ AddLog::AddLog(int id, const std::string& msg) : AddLog(Vec { Vec::value_type(id
 {
 }
 
-AddLog::AddLog(const Vec& msgs) : Update("add_log")
+AddLog::AddLog(const Vec& msgs, int idCursor) : Update("add_log")
 {
-	auto msgsNode = m_root.AddArray("items");
-	for (auto& msg : msgs)
-	{
-		auto msgNode = msgsNode.AppendElement();
-		msgNode.SetAttribute("id", msg.first);
-		msgNode.SetAttribute("message", msg.second);
-	}
+	AddLogItems(msgs, m_root);
+	if (idCursor)
+		m_root.SetAttribute("cursor", idCursor);
+}
+
+PrependLog::PrependLog(const AddLog::Vec& msgs, int idCursor) : Update("prepend_log")
+{
+	AddLogItems(msgs, m_root);
+	m_root.SetAttribute("cursor", idCursor);
 }
 
 RemoveLog::RemoveLog(int id) : Update("remove_log")
@@ -617,7 +664,7 @@ ChooseMoveDst::ChooseMoveDst(const std::set<MapPos>& dsts) : Choose("move_dst")
 
 ChooseUpgrade::ChooseUpgrade(const Team& team, std::vector<ShipPart> parts, int allowedUpgrades, bool canRemove) : Choose("upgrade")
 {
-	auto appendPart = [](Json::Array& array, ShipPart part)
+	auto appendPart = [](JsonWriter::Array& array, ShipPart part)
 	{
 		auto partNode = array.AppendElement();
 		partNode.SetAttribute("name", ::EnumToString(part));
@@ -3,7 +3,8 @@
 #include "MapPos.h"
 #include "Hex.h"
 
-#include "libKernel/Json.h"
+#include "JsonWriter.h"
+#include "GameDirectory.h"
 
 #include <string>
 #include <memory>
@@ -32,8 +33,8 @@ public:
 	std::string GetXML() const;
 
 protected:
-	Json::Document m_doc;
-	Json::Element m_root;
+	JsonWriter m_writer;
+	JsonWriter::Element m_root;
 };
 
 struct Response : Message
@@ -44,9 +45,6 @@ struct Response : Message
 struct Command : Message
 {
 	Command(const std::string& cmd);
-	//virtual void Create() { m_doc.In}
-	
-	Json::Element* m_pRoot;
 };
 
 struct Show : Command
@@ -64,7 +62,10 @@ struct Choose : Command
 	Choose(const std::string& param);
 };
 
-struct UpdateGameList : Update { UpdateGameList(const Player& player); };
+struct UpdateSession : Update { UpdateSession(int epoch); };
+struct UpdateCodec : Update { UpdateCodec(const std::vector<std::string>& words); };
+struct UpdateGameList : Update { UpdateGameList(const std::vector<GameDirectory::EntryPtr>& entries, const Player& player); };
+struct UpdateGameListEntry : Update { UpdateGameListEntry(const GameDirectory::Entry& entry, bool bMine); };
 struct UpdateLobby : Update { UpdateLobby(const Game& game); };
 struct UpdateLobbyControls : Update { UpdateLobbyControls(const Player& player); };
 struct UpdateChoose : Update { UpdateChoose(const LiveGame& game); };
@@ -81,6 +82,7 @@ struct UpdateColonyShips : Update { UpdateColonyShips(const Team& team); };
 struct UpdatePassed : Update { UpdatePassed(const Team& team); };
 struct UpdateBlueprints : Update { UpdateBlueprints(const Team& team); };
 struct UpdateMap : Update { UpdateMap(const Game& game); };
+struct UpdateMapDelta : Update { UpdateMapDelta(const Game& game, const std::set<MapPos>& positions, int baseVersion); };
 struct UpdateReviewUI : Update { UpdateReviewUI(const ReviewGame& game); };
 struct UpdateTechnologies : Update { UpdateTechnologies(const Game& game); };
 struct UpdateRound : Update { UpdateRound(const Game& game); };
@@ -93,8 +95,9 @@ struct AddLog : Update
 {
 	typedef std::vector<std::pair<int, std::string>> Vec;
 	AddLog(int id, const std::string& msg);
-	AddLog(const Vec& msgs);
+	AddLog(const Vec& msgs, int idCursor = 0); // idCursor: fetch_logs can go back from here, if non-zero.
 };
+struct PrependLog : Update { PrependLog(const AddLog::Vec& msgs, int idCursor); };
 struct RemoveLog : Update { RemoveLog(int id); };
 //struct UpdateUndo : Update { UpdateUndo(bool bEnable); };
 
@@ -110,7 +113,7 @@ struct ChooseExploreHex : Choose
 	ChooseExploreHex(int x, int y, bool bCanTake, bool bCanUndo);
 	void AddHexChoice(int idHex, const std::vector<int>& rotations, bool bCanInfluence);
 private:
-	Json::Array m_hexes;
+	JsonWriter::Array m_hexes;
 };
 struct ChooseDiscovery : Choose { ChooseDiscovery(DiscoveryType discovery, bool canKeep, bool canUse); };
 struct ChooseColonisePos : Choose { ChooseColonisePos(const std::vector<MapPos>& hexes); };
@@ -0,0 +1,91 @@
+#include "stdafx.h"
+#include "PasswordHasher.h"
+#include "Player.h"
+
+#include <algorithm>
+#include <future>
+
+const int PasswordHasher::ThreadCount = 2;
+const int PasswordHasher::MaxQueued = 16; // Well under civetweb's worker count, so most workers are always free.
+const int PasswordHasher::MaxAttempts = 5;
+const double PasswordHasher::RefillSeconds = 12;
+const size_t PasswordHasher::MaxBuckets = 1024;
+
+PasswordHasher::PasswordHasher() : m_nQueued(0), m_pool(ThreadCount)
+{
+}
+
+PasswordHasher::Result PasswordHasher::Check(const std::string& address, const std::string& password, const std::string& hash, bool& bMatch)
+{
+	return Run(address, [&] { bMatch = Player::CheckPassword(password, hash); });
+}
+
+PasswordHasher::Result PasswordHasher::Hash(const std::string& address, const std::string& password, std::string& hash)
+{
+	return Run(address, [&] { hash = Player::HashPassword(password); });
+}
+
+// The caller still waits for the result (civetweb wants the response from the handler), but it waits idle,  
+// and for no longer than MaxQueued hashes shared between ThreadCount threads. 
+PasswordHasher::Result PasswordHasher::Run(const std::string& address, std::function<void()> fn)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_nQueued >= MaxQueued)
+			return Result::Busy;
+		if (!TakeToken(address))
+			return Result::Limited;
+		++m_nQueued;
+	}
+
+	auto pTask = std::make_shared<std::packaged_task<void()>>(std::move(fn));
+	auto future = pTask->get_future();
+
+	m_pool.Push([this, pTask]
+	{
+		(*pTask)();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_nQueued;
+	});
+
+	future.get(); // Rethrows.
+	return Result::OK;
+}
+
+bool PasswordHasher::TakeToken(const std::string& address)
+{
+	const auto now = Clock::now();
+
+	// Forget addresses that are back to full. If none are, forget the one we heard from longest ago.
+	if (m_buckets.size() >= MaxBuckets && !m_buckets.count(address))
+	{
+		for (auto it = m_buckets.begin(); it != m_buckets.end();)
+			it = GetTokens(it->second, now) >= MaxAttempts ? m_buckets.erase(it) : std::next(it);
+
+		if (m_buckets.size() >= MaxBuckets)
+			m_buckets.erase(std::min_element(m_buckets.begin(), m_buckets.end(),
+				[](const std::pair<const std::string, Bucket>& lhs, const std::pair<const std::string, Bucket>& rhs) { return lhs.second.time < rhs.second.time; }));
+	}
+
+	auto it = m_buckets.insert(std::make_pair(address, Bucket{ (double)MaxAttempts, now })).first;
+	Bucket& bucket = it->second;
+
+	bucket.tokens = GetTokens(bucket, now);
+	bucket.time = now;
+
+	if (bucket.tokens < 1)
+	{
+		std::cout << "INFO: Too many password attempts from " << address << std::endl;
+		return false;
+	}
+
+	bucket.tokens -= 1;
+	return true;
+}
+
+double PasswordHasher::GetTokens(const Bucket& bucket, Clock::time_point now)
+{
+	const double elapsed = std::chrono::duration<double>(now - bucket.time).count();
+	return std::min((double)MaxAttempts, bucket.tokens + elapsed / RefillSeconds);
+}
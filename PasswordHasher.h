@@ -0,0 +1,46 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Runs bcrypt on a few threads of its own, so a burst of logins queues here instead of burning every HTTP worker.
+// Each remote address gets a few attempts, topped up over time. 
+class PasswordHasher
+{
+public:
+	enum class Result { OK, Busy, Limited };
+
+	PasswordHasher();
+
+	Result Check(const std::string& address, const std::string& password, const std::string& hash, bool& bMatch);
+	Result Hash(const std::string& address, const std::string& password, std::string& hash);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Bucket
+	{
+		double tokens;
+		Clock::time_point time;
+	};
+
+	Result Run(const std::string& address, std::function<void()> fn);
+	bool TakeToken(const std::string& address); // Locked.
+	static double GetTokens(const Bucket& bucket, Clock::time_point now);
+
+	static const int ThreadCount;
+	static const int MaxQueued;
+	static const int MaxAttempts;
+	static const double RefillSeconds;
+	static const size_t MaxBuckets; // Addresses remembered at once.
+
+	std::mutex m_mutex;
+	std::map<std::string, Bucket> m_buckets; // By address.
+	int m_nQueued;
+	WorkerPool m_pool;
+};
@@ -12,26 +12,24 @@ Player::Player() : m_id(0), m_idCurrentGame(0)
 {
 }
 
-Player::Player(int id, const std::string& email, const std::string& name, const std::string& password) :
-	m_id(id), m_email(email), m_name(name), m_idCurrentGame(0)
+Player::Player(int id, const std::string& email, const std::string& name, const std::string& passwordHash) :
+	m_id(id), m_idCurrentGame(0), m_email(email), m_name(name), m_passwordHash(passwordHash)
 {
-	m_passwordHash = HashPassword(password);
-
 	Save();
 }
 
-bool Player::CheckPassword(const std::string& password) const
+bool Player::CheckPassword(const std::string& password, const std::string& hash)
 {
-	if (password.empty())
+	if (password.empty() || hash.empty()) // Test players have no password.
 		return false;
 
-	char hash[BCRYPT_HASHSIZE];
-	VERIFY(::bcrypt_hashpw(password.c_str(), m_passwordHash.c_str(), hash) == 0);
+	char newHash[BCRYPT_HASHSIZE];
+	VERIFY(::bcrypt_hashpw(password.c_str(), hash.c_str(), newHash) == 0);
 	
-	return m_passwordHash == hash;
+	return hash == newHash;
 }
 
-std::string Player::HashPassword(const std::string& password) const
+std::string Player::HashPassword(const std::string& password)
 {
 	char salt[BCRYPT_HASHSIZE];
 	VERIFY(::bcrypt_gensalt(12, salt) == 0);
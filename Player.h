@@ -13,12 +13,14 @@ class Player
 public:
 	Player();
 	Player(const Player&) = delete;
-	Player(int id, const std::string& email, const std::string& name, const std::string& password);
+	Player(int id, const std::string& email, const std::string& name, const std::string& passwordHash);
 
 	int GetID() const { return m_id; }
 	const std::string& GetName() const { return m_name; }
 	const std::string& GetEmail() const { return m_email; }
+	int GetCurrentGameID() const { return m_idCurrentGame; }
 	bool CheckPasswordHash(const std::string& hash) const;
+	const std::string& GetPasswordHash() const { return m_passwordHash; }
 
 	const std::string& GetSessionHash() const { return m_sessionHash; }
 	void SetSessionHash(const std::string& hash);
@@ -27,7 +29,6 @@ public:
 	const ReviewGame* GetCurrentReviewGame() const;
 	const Game* GetCurrentGame() const;
 	const Team* GetCurrentTeam() const;
-	bool CheckPassword(const std::string& password) const;
 
 	void SetCurrentGame(const Game* pGame);
 	void RejoinCurrentGame();
@@ -36,9 +37,11 @@ public:
 	void Save(Serial::SaveNode& node) const;
 	void Load(const Serial::LoadNode& node);
 
+	// Slow (bcrypt), so call these via PasswordHasher.
+	static bool CheckPassword(const std::string& password, const std::string& hash);
+	static std::string HashPassword(const std::string& password);
+
 private:
-	std::string HashPassword(const std::string& password) const;
-		
 	int m_id;
 	int m_idCurrentGame;
 	std::string m_email, m_name, m_passwordHash;
@@ -15,6 +15,18 @@ namespace
 		picosha2::hash256_hex_string(str, hash);
 		return hash;
 	}
+
+	// Doesn't stop at the first difference, so timing doesn't leak how much of a session hash matched.
+	bool ConstantTimeEquals(const std::string& a, const std::string& b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		unsigned char diff = 0;
+		for (size_t i = 0; i < a.size(); ++i)
+			diff |= a[i] ^ b[i];
+		return diff == 0;
+	}
 }
 
 PlayerList::PlayerList(const IServer::Request& request) : PlayerList(request.GetQueries().GetInt("player"), request.GetCookies())
@@ -31,7 +43,7 @@ PlayerList::PlayerList(int playerId, const IServer::StringMap& cookies) : m_curr
 		std::string session = cookies.Get(std::string("session_") + ::FormatInt(i));
 
 		if (Player* player = Players::Find(id))
-			if (GetHash(session) == player->GetSessionHash())
+			if (ConstantTimeEquals(GetHash(session), player->GetSessionHash()))
 			{
 				m_players.push_back(std::make_pair(player, session));
 				if (playerId == player->GetID())
@@ -2,20 +2,26 @@
 #include "Players.h"
 #include "App.h"
 #include "Util.h"
+#include "WorkerPool.h"
+#include "Game.h"
 
 #include "libKernel/Filesystem.h"
 #include "libKernel/Xml.h"
 
+#include <chrono>
+
 int Players::s_nNextID = 1;
 int Players::s_nNextTestID = -1;
 std::map<int, PlayerPtr> Players::s_map;
+std::unordered_map<std::string, Player*> Players::s_emailIndex;
 
-Player& Players::Add(const std::string& email, const std::string& name, const std::string& password)
+Player& Players::Add(const std::string& email, const std::string& name, const std::string& passwordHash)
 {
 	VERIFY(Find(email) == nullptr);
 
-	Player* p = new Player(s_nNextID, Util::ToLower(email), name, password);
+	Player* p = new Player(s_nNextID, Util::ToLower(email), name, passwordHash);
 	ASSERT(s_map.insert(std::make_pair(s_nNextID, PlayerPtr(p))).second);
+	s_emailIndex[p->GetEmail()] = p;
 	++s_nNextID;
 	return *p;
 }
@@ -43,12 +49,8 @@ Player* Players::Find(int idPlayer)
 
 Player* Players::Find(const std::string& email) 
 {
-	std::string lower = Util::ToLower(email);
-
-	for (auto& i : s_map)
-		if (lower == i.second->GetEmail())
-			return i.second.get();
-	return nullptr;
+	auto i = s_emailIndex.find(Util::ToLower(email));
+	return i == s_emailIndex.end() ? nullptr : i->second;
 }
 
 void Players::RejoinCurrentGame()
@@ -57,6 +59,13 @@ void Players::RejoinCurrentGame()
 		i.second->RejoinCurrentGame();
 }
 
+void Players::RejoinGame(const Game& game)
+{
+	for (auto& i : s_map)
+		if (i.second->GetCurrentGameID() == game.GetID())
+			game.AddPlayer(i.second.get());
+}
+
 std::wstring Players::GetPath()
 {
 	return L"data/players/";
@@ -67,16 +76,32 @@ void Players::Load()
 	VERIFY_SERIAL(s_map.empty());
 
 	auto files = Kernel::FileSystem::FindFilesInDir(GetPath(), L"*.xml");
+	std::vector<PlayerPtr> players(files.size());
 
-	for (auto& f : files)
+	auto start = std::chrono::steady_clock::now();
 	{
-		PlayerPtr player(new Player);
-		if (Serial::LoadClass(GetPath() + f, *player))
+		WorkerPool pool;
+		for (size_t i = 0; i < files.size(); ++i)
+			pool.Push([&, i]
+			{
+				PlayerPtr player(new Player);
+				if (Serial::LoadClass(GetPath() + files[i], *player))
+					players[i] = std::move(player);
+			});
+		pool.Wait();
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	for (auto& player : players)
+		if (player)
 		{
 			s_nNextID = std::max(s_nNextID, player->GetID() + 1);
+			if (!player->GetEmail().empty())
+				ASSERT(s_emailIndex.insert(std::make_pair(Util::ToLower(player->GetEmail()), player.get())).second);
 			ASSERT(s_map.insert(std::make_pair(player->GetID(), std::move(player))).second);
 		}
 		else
 			ASSERT(false);
-	}
+
+	std::cout << "INFO: Loaded " << s_map.size() << " of " << files.size() << " players in " << (int)ms << " ms" << std::endl;
 }
@@ -2,8 +2,11 @@
 
 #include "Player.h"
 
+class Game;
+
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 class Players
 {
@@ -11,7 +14,7 @@ public:
 	static void Load();
 	static std::wstring GetPath();
 
-	static Player& Add(const std::string& email, const std::string& name, const std::string& password);
+	static Player& Add(const std::string& email, const std::string& name, const std::string& passwordHash);
 	static Player& AddTest();
 
 	static Player& Get(int idPlayer);
@@ -19,9 +22,11 @@ public:
 	static Player* Find(const std::string& email);
 
 	static void RejoinCurrentGame();
+	static void RejoinGame(const Game& game); // After loading it again. 
 
 private:
 	static std::map<int, PlayerPtr> s_map;
+	static std::unordered_map<std::string, Player*> s_emailIndex; // Lower case. Test players have no email, so aren't in it.
 	static int s_nNextID, s_nNextTestID;
 };
 
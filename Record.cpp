@@ -7,8 +7,10 @@
 #include "Output.h"
 #include "Player.h"
 
+// Constructed before the record changes the game. 
 RecordContext::RecordContext(Game& game, const Controller* controller) : m_game(game), m_controller(controller) 
 {
+	Controller::OnGameChanged(game);
 }
 
 void RecordContext::SendMessage(const Output::Message& msg, const Player* pPlayer) const
@@ -17,6 +19,18 @@ void RecordContext::SendMessage(const Output::Message& msg, const Player* pPlaye
 		m_controller->SendMessage(msg, m_game, pPlayer);
 }
 
+void RecordContext::SendMapDelta() const
+{
+	if (!m_controller)
+		return; // Keep them dirty: whoever shows the game next sends the whole map.
+
+	Map& map = GetGameState().GetMap();
+	int baseVersion = map.GetVersion();
+	auto dirty = map.TakeDirty();
+	if (!dirty.empty())
+		m_controller->SendMessage(Output::UpdateMapDelta(m_game, dirty, baseVersion), m_game);
+}
+
 //-----------------------------------------------------------------------------
 
 Record::Record() : m_id(-1) {}
@@ -25,23 +39,26 @@ Record::~Record() {}
 
 void Record::DoImmediate(const ReviewGame& game, const std::function<void(ReviewGame&)>& fn)
 {
+	Controller::OnGameChanged(game);
 	fn(const_cast<ReviewGame&>(game));
 }
 
-void Record::Do(const ReviewGame& game, const Controller& controller)
+void Record::Do(const ReviewGame& game, const Controller* controller)
 {
 	Game& game2 = const_cast<ReviewGame&>(game);
-	RecordContext context(game2, &controller);
+	RecordContext context(game2, controller);
 	Apply(true, game2, context.GetGameState());
-	Update(game, context);
+	if (controller)
+		Update(game, context);
 }
 
-void Record::Undo(const ReviewGame& game, const Controller& controller)
+void Record::Undo(const ReviewGame& game, const Controller* controller)
 {
 	Game& game2 = const_cast<ReviewGame&>(game);
-	RecordContext context(game2, &controller);
+	RecordContext context(game2, controller);
 	Apply(false, game2, context.GetGameState());
-	Update(game, context);
+	if (controller)
+		Update(game, context);
 }
 
 void Record::Do(LiveGame& game, const Controller* controller) 
@@ -2,6 +2,7 @@
 
 #include "App.h"
 #include "GameStateAccess.h"
+#include "Controller.h"
 
 #include <memory>
 #include <functional>
@@ -28,6 +29,19 @@ class RecordContext : public GameStateAccess
 public:
 	RecordContext(Game& game, const Controller* controller);
 	void SendMessage(const Output::Message& msg, const Player* pPlayer = nullptr) const;
+	template <typename T, typename... Args>
+	void SendSharedMessage(const std::string& subject, const Args&... args) const
+	{
+		if (m_controller)
+			m_controller->SendSharedMessage<T>(m_game, subject, nullptr, args...);
+	}
+	template <typename T, typename... Args>
+	void SendSecretMessage(const std::string& subject, const Player& owner, const Args&... args) const
+	{
+		if (m_controller)
+			m_controller->SendSecretMessage<T>(m_game, subject, owner, nullptr, args...);
+	}
+	void SendMapDelta() const; // The hexes changed since the last map update.
 	GameState& GetGameState() const { return __super::GetGameState(m_game); }
 	const Game& GetGame() const { return m_game; }
 private:
@@ -46,8 +60,8 @@ public:
 
 	static void DoImmediate(const ReviewGame& game, const std::function<void(ReviewGame&)>& fn);
 
-	void Do(const ReviewGame& game, const Controller& controller);
-	void Undo(const ReviewGame& game, const Controller& controller);
+	void Do(const ReviewGame& game, const Controller* controller);
+	void Undo(const ReviewGame& game, const Controller* controller);
 
 	void Do(LiveGame& game, const Controller* controller);
 	void Undo(LiveGame& game, const Controller* controller);
@@ -0,0 +1,37 @@
+#include "stdafx.h"
+#include "ReplayBuffer.h"
+
+const size_t ReplayBuffer::MaxFrames = 256;
+const size_t ReplayBuffer::MaxBytes = 1 << 20;
+
+ReplayBuffer::ReplayBuffer() : m_firstSeq(1), m_bytes(0)
+{
+}
+
+int ReplayBuffer::Add(const std::string& msgs, std::string& frame)
+{
+	const int seq = m_firstSeq + (int)m_frames.size();
+
+	frame = "{\"seq\":" + std::to_string(seq) + ",\"msgs\":" + msgs + "}";
+	m_frames.push_back(frame);
+	m_bytes += frame.size();
+
+	// Always keep the latest, however big.
+	while (m_frames.size() > MaxFrames || (m_bytes > MaxBytes && m_frames.size() > 1))
+	{
+		m_bytes -= m_frames.front().size();
+		m_frames.pop_front();
+		++m_firstSeq;
+	}
+	return seq;
+}
+
+bool ReplayBuffer::GetFramesAfter(int seq, std::vector<std::string>& frames) const
+{
+	const int nextSeq = m_firstSeq + (int)m_frames.size();
+	if (seq + 1 < m_firstSeq || seq >= nextSeq)
+		return false;
+
+	frames.assign(m_frames.begin() + (seq + 1 - m_firstSeq), m_frames.end());
+	return true;
+}
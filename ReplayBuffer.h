@@ -0,0 +1,27 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The last frames sent to a player, numbered, so a client that reconnects can be sent just what it missed.
+class ReplayBuffer
+{
+public:
+	ReplayBuffer();
+
+	int Add(const std::string& msgs, std::string& frame); // Wraps msgs in a numbered frame; returns its number.
+	bool GetFramesAfter(int seq, std::vector<std::string>& frames) const; // False if some have been dropped.
+
+	std::mutex& GetMutex() const { return m_mutex; } // Held while adding and sending a frame, to keep them in order.
+
+	static const size_t MaxFrames;
+	static const size_t MaxBytes;
+
+private:
+	std::deque<std::string> m_frames;
+	int m_firstSeq; // Of m_frames.front().
+	size_t m_bytes;
+	mutable std::mutex m_mutex;
+};
@@ -16,12 +16,12 @@ ReputationSlots::ReputationSlots(int a, int e, int r)
 
 //-----------------------------------------------------------------------------
 
-ReputationTrack::ReputationTrack() : m_team(nullptr)
+ReputationTrack::ReputationTrack() : m_race(RaceType::None), m_pAllies(nullptr)
 {
 }
 
 ReputationTrack::ReputationTrack(const ReputationTrack& rhs) : 
-m_team(nullptr), m_repTiles(rhs.m_repTiles)
+m_race(rhs.m_race), m_pAllies(nullptr), m_repTiles(rhs.m_repTiles)
 {
 }
 
@@ -30,15 +30,16 @@ bool ReputationTrack::operator==(const ReputationTrack& rhs) const
 	return m_repTiles == rhs.m_repTiles;
 }
 
+// Called by each team sharing the state.
 void ReputationTrack::SetTeam(const Team& team)
 {
-	VERIFY_MODEL(!m_team);
-	m_team = &team;
+	VERIFY_MODEL(m_race == RaceType::None || m_race == team.GetRace());
+	m_race = team.GetRace();
 }
 
 ReputationSlots ReputationTrack::GetSlots() const
 {
-	return Race(m_team->GetRace()).GetReputationSlots();
+	return Race(m_race).GetReputationSlots();
 }
 
 int ReputationTrack::GetSlotCount() const
@@ -65,7 +66,7 @@ int ReputationTrack::GetFirstReputationTileSlot() const
 	ReputationSlots slots = GetSlots();
 
 	int nAmbassadorSlots = slots.GetCount(ReputationType::Ambassador);
-	int nEitherSlotsUsed = std::max(0, (int)m_team->GetAllies().size() - slots.GetCount(ReputationType::Ambassador));
+	int nEitherSlotsUsed = std::max(0, (int)m_pAllies->size() - slots.GetCount(ReputationType::Ambassador));
 	return nAmbassadorSlots + nEitherSlotsUsed;
 }
 
@@ -123,7 +124,7 @@ void ReputationTrack::RemoveReputationTile(int val)
 bool ReputationTrack::CanAddAmbassador() const
 {
 	ReputationSlots slots = GetSlots();
-	return (int)m_team->GetAllies().size() < slots.GetCount(ReputationType::Ambassador) + slots.GetCount(ReputationType::Either);
+	return (int)m_pAllies->size() < slots.GetCount(ReputationType::Ambassador) + slots.GetCount(ReputationType::Either);
 }
 
 bool ReputationTrack::OnAmbassadorAdded()
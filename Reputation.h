@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <set>
 
 enum class ReputationType { Ambassador, Either, Reputation, _Count };
 
@@ -16,6 +17,8 @@ private:
 };
 
 class Team;
+enum class Colour;
+enum class RaceType;
 
 class ReputationTrack
 {
@@ -25,6 +28,7 @@ public:
 	bool operator==(const ReputationTrack& rhs) const;
 
 	void SetTeam(const Team& team);
+	void SetAllies(const std::set<Colour>& allies) { m_pAllies = &allies; }
 
 	int GetSlotCount() const;
 	ReputationType GetSlotType(int iSlot) const;
@@ -49,5 +53,8 @@ private:
 	int GetEmptyReputationTileSlots() const;
 
 	std::vector<int> m_repTiles;
-	const Team* m_team;
+
+	// The owning TeamState may be shared between games, so we can't point back to a Team.
+	RaceType m_race;
+	const std::set<Colour>* m_pAllies; // Owning TeamState's.
 };
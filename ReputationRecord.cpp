@@ -48,9 +48,11 @@ void ReputationRecord::Apply(bool bDo, const Game & game, GameState & gameState)
 
 void ReputationRecord::Update(const Game& game, const RecordContext& context) const
 {
-	for (auto& team : game.GetTeams())
-		for (auto& pair : m_values)
-			context.SendMessage(Output::UpdateReputationTrack(game.GetTeam(pair.first), pair.first == team->GetColour()));
+	for (auto& pair : m_values)
+	{
+		const Team& team = game.GetTeam(pair.first);
+		context.SendSecretMessage<Output::UpdateReputationTrack>(::EnumToString(pair.first), team.GetPlayer(), team);
+	}
 }
 
 void ReputationRecord::Save(Serial::SaveNode& node) const
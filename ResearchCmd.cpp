@@ -253,7 +253,7 @@ void ResearchArtifactCmd::UpdateClient(const Controller& controller, const LiveG
 {
 	m_nArtifacts = 0;
 
-	for (auto& h : game.GetMap().GetHexes())
+	for (auto h : game.GetMap().GetHexes())
 		if (h.second->IsOwnedBy(GetTeam(game)))
 			m_nArtifacts += h.second->HasArtifact();
 
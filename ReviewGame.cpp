@@ -5,6 +5,8 @@
 #include "App.h"
 #include "Player.h"
 #include "Record.h"
+#include "StartGameRecord.h"
+#include "StartRoundRecord.h"
 
 
 ReviewGame::ReviewGame(int id, const Player& owner, const LiveGame& live) : 
@@ -22,16 +24,16 @@ const std::vector<RecordPtr>& ReviewGame::GetRecords() const
 	return Games::GetLive(m_idLive).GetRecords();
 }
 
-std::vector<std::pair<int, std::string>> ReviewGame::GetLogs() const
+const LogCache& ReviewGame::GetLogCache() const
 {
-	return Games::GetLive(m_idLive).GetLogs();
+	return Games::GetLive(m_idLive).GetLogCache();
 }
 
 void ReviewGame::Advance(const Controller& controller)
 {
 	VERIFY_MODEL_MSG("Already at end", CanAdvance());
 	Record& rec = *GetRecords()[m_iRecord++];
-	rec.Do(*this, controller);
+	rec.Do(*this, &controller);
 
 	// Skip messages.
 	while (CanAdvance() && GetRecords()[m_iRecord]->IsMessageRecord())
@@ -47,7 +49,7 @@ void ReviewGame::Retreat(const Controller& controller)
 		--m_iRecord;
 
 	if (CanRetreat())
-		GetRecords()[--m_iRecord]->Undo(*this, controller);
+		GetRecords()[--m_iRecord]->Undo(*this, &controller);
 }
 
 bool ReviewGame::CanAdvance() const
@@ -60,6 +62,66 @@ bool ReviewGame::CanRetreat() const
 	return m_iRecord > 1;
 }
 
+void ReviewGame::SeekToRecord(int idRecord)
+{
+	auto& records = GetRecords();
+	auto it = std::find_if(records.begin(), records.end(), [&](const RecordPtr& r) { return r->GetID() == idRecord; });
+	VERIFY_INPUT_MSG("record not found", it != records.end());
+	SeekToIndex(int(it - records.begin()));
+}
+
+// Positions after the record that starts the round, as Advance would.
+void ReviewGame::SeekToRound(int round)
+{
+	auto starts = GetRoundStarts();
+	VERIFY_INPUT_MSG("invalid round", round >= 0 && round < (int)starts.size());
+	SeekToIndex(starts[round]);
+
+	while (CanAdvance() && GetRecords()[m_iRecord]->IsMessageRecord())
+		++m_iRecord;
+}
+
+int ReviewGame::GetRoundCount() const
+{
+	return (int)GetRoundStarts().size();
+}
+
+std::vector<int> ReviewGame::GetRoundStarts() const
+{
+	std::vector<int> starts;
+	auto& records = GetRecords();
+	for (int i = 0; i < (int)records.size(); ++i)
+		if (dynamic_cast<const StartGameRecord*>(records[i].get()) || dynamic_cast<const StartRoundRecord*>(records[i].get()))
+			starts.push_back(i + 1);
+	return starts;
+}
+
+// Restores the nearest keyframe if that's closer than stepping from here.
+void ReviewGame::SeekToIndex(int iRecord)
+{
+	auto& records = GetRecords();
+	VERIFY_INPUT(iRecord >= 1 && iRecord <= (int)records.size());
+
+	const LiveGame& live = Games::GetLive(m_idLive);
+	auto keyframe = live.FindKeyframe(iRecord);
+	if (keyframe.second && iRecord - keyframe.first < std::abs(iRecord - m_iRecord))
+	{
+		m_state.Restore(*keyframe.second);
+		m_iRecord = keyframe.first;
+	}
+
+	while (m_iRecord != iRecord)
+	{
+		if (m_iRecord < iRecord)
+			records[m_iRecord++]->Do(*this, nullptr);
+		else
+			records[--m_iRecord]->Undo(*this, nullptr);
+
+		if (m_iRecord % LiveGame::KeyframeInterval == 0)
+			live.AddKeyframe(m_iRecord, m_state);
+	}
+}
+
 int ReviewGame::GetNextRecordID() const
 {
 	return CanAdvance() ? GetRecords()[m_iRecord]->GetID() : 0;
@@ -71,7 +133,7 @@ void ReviewGame::OnPreRecordPop(const Controller& controller)
 	VERIFY_MODEL(CanRetreat() && m_iRecord <= (int)GetRecords().size() && pop >= 0);
 
 	if (m_iRecord > pop)
-		GetRecords()[pop]->Undo(*this, controller);
+		GetRecords()[pop]->Undo(*this, &controller);
 
 	if (m_iRecord >= pop) // Skip trailing messages. 
 		m_iRecord = (int)GetRecords().size() - 1;
@@ -18,19 +18,26 @@ public:
 	int GetLiveGameID() const { return m_idLive; }
 
 	virtual bool HasStarted() const override { return true; }
-	virtual std::vector<std::pair<int, std::string>> GetLogs() const override;
+	virtual const LogCache& GetLogCache() const override;
 
 	void Advance(const Controller& controller);
 	void Retreat(const Controller& controller);
 
+	// No client updates: send a full update afterwards.
+	void SeekToRecord(int idRecord); // Positions before the record.
+	void SeekToRound(int round);
+
 	bool CanAdvance() const;
 	bool CanRetreat() const;
 	int GetNextRecordID() const;
+	int GetRoundCount() const; // Rounds started so far in the live game.
 
 	void OnPreRecordPop(const Controller& controller);
 
 private:
 	const std::vector<RecordPtr>& GetRecords() const;
+	std::vector<int> GetRoundStarts() const; // Record index of each round's start.
+	void SeekToIndex(int iRecord);
 
 	int m_idLive;
 	int m_iRecord; // Last undone record.
@@ -4,60 +4,140 @@
 
 SaveThread* SaveThread::s_instance;
 
-void SaveThread::Push(const LiveGame& game)
+SaveThread::SaveThread(int nWorkers) : _head(nullptr), _abort(false), _workers(nWorkers)
+{
+	assert(!s_instance);
+	s_instance = this;
+	_collector = std::thread(&SaveThread::Go, this);
+}
+
+SaveThread::~SaveThread()
 {
-	if (std::find(_queue.begin(), _queue.end(), &game) != _queue.end())
-		return;
-	
 	{
-		std::lock_guard<std::mutex> lock(_queueMutex);
-		_queue.push_back(&game);
+		std::lock_guard<std::mutex> lock(_wakeMutex);
+		_abort = true;
 	}
 	_cv.notify_one();
+	_collector.join();
+
+	s_instance = nullptr;
 }
 
-const LiveGame* SaveThread::Pop()
+void SaveThread::Push(const LiveGame& game)
 {
-	const LiveGame* game = nullptr;
+	if (game.m_bSaveQueued.exchange(true))
+		return; // Its save hasn't started yet, so it'll include this commit.
 
-	std::lock_guard<std::mutex> lock(_queueMutex);
-	if (!_queue.empty())
+	Node* node = new Node{ &game, nullptr };
+	Node* head = _head.load(std::memory_order_relaxed);
+	do
+		node->next = head; // The collector may take node as soon as it's in, so don't read it after.
+	while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+	// Only the first push needs to wake the collector. Taking the mutex means it can't miss the notification.
+	if (!head)
 	{
-		game = _queue.front();
-		_queue.pop_front();
+		{
+			std::lock_guard<std::mutex> lock(_wakeMutex);
+		}
+		_cv.notify_one();
 	}
+}
 
-	return game;
+bool SaveThread::IsPending(const LiveGame& game) const
+{
+	return game.m_bSaveQueued || game.m_bSaving;
+}
+
+SaveThread::Node* SaveThread::TakeAll()
+{
+	Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+
+	Node* oldest = nullptr;
+	while (node)
+	{
+		Node* next = node->next;
+		node->next = oldest;
+		oldest = node;
+		node = next;
+	}
+	return oldest;
 }
 
 void SaveThread::Go()
 {
-	while (!_abort)
+	for (;;)
 	{
-		std::unique_lock<std::mutex> lock(_cvMutex);
-		_cv.wait(lock);
+		bool bAbort = false;
+		{
+			std::unique_lock<std::mutex> lock(_wakeMutex);
+			_cv.wait(lock, [&] { return _abort || _head.load() != nullptr; });
+			bAbort = _abort;
+		}
 
-		while (const LiveGame* game = Pop())
+		// Drain what's left before stopping.
+		while (Node* node = TakeAll())
 		{
-			std::lock_guard<std::mutex> gameLock(game->GetMutex());
-			game->Save();
-			std::cout << "Saved game: " << game->GetName() << std::endl;
+			std::vector<const LiveGame*> games;
+			while (node)
+			{
+				games.push_back(node->game);
+
+				Node* next = node->next;
+				delete node;
+				node = next;
+			}
+			SaveBatch(games);
 		}
+
+		if (bAbort)
+			return;
 	}
 }
 
-SaveThread::SaveThread()
+void SaveThread::SaveBatch(const std::vector<const LiveGame*>& games)
 {
-	assert(!s_instance);
-	s_instance = this;
-	_worker = std::thread(&SaveThread::Go, this);
-}
+	std::vector<DurableFile::Item> items(games.size());
+	std::vector<char> prepared(games.size()); // Not vector<bool>: workers write these concurrently.
 
-SaveThread::~SaveThread()
-{
-	_abort = true;
-	_cv.notify_one();
-	_worker.join();
+	for (size_t i = 0; i < games.size(); ++i)
+		_workers.Push([&, i]
+		{
+			const LiveGame& game = *games[i];
+			std::lock_guard<std::mutex> gameLock(game.GetMutex());
 
-	s_instance = nullptr;
+			// Cleared under the lock: commits from now on need another save. 
+			game.m_bSaving = true;
+			game.m_bSaveQueued = false;
+			try
+			{
+				prepared[i] = game.PrepareSave(items[i]);
+			}
+			catch (Exception& e)
+			{
+				std::cerr << "ERROR: Failed to save game: " << game.GetName() << ": " << e.what() << std::endl;
+			}
+		});
+	_workers.Wait();
+
+	std::vector<DurableFile::Item> commits;
+	for (size_t i = 0; i < games.size(); ++i)
+		if (prepared[i])
+			commits.push_back(items[i]);
+	DurableFile::Commit(commits);
+
+	auto commit = commits.begin();
+	for (size_t i = 0; i < games.size(); ++i)
+	{
+		const LiveGame& game = *games[i];
+		std::lock_guard<std::mutex> gameLock(game.GetMutex());
+		if (prepared[i])
+		{
+			const DurableFile::Item& item = *commit++;
+			game.FinishSave(item);
+			if (item.bOK)
+				std::cout << "Saved game: " << game.GetName() << std::endl;
+		}
+		game.m_bSaving = false;
+	}
 }
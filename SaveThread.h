@@ -1,29 +1,48 @@
 #pragma once
 
+#include "WorkerPool.h"
+
+#include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <thread>
-#include <deque>
+#include <vector>
 
 class LiveGame;
 
+// Saves games in the background. Pushing never blocks: games go on a lock-free list, and a game that's already 
+// waiting isn't added again, so a burst of commits to one game costs one save. 
+// The collector thread takes everything queued as a batch. Workers serialise each game under its mutex, then the batch
+// is committed to disk as one group with no game locked. A game is in a batch at most once, and batches don't overlap,
+// so each save has the game's latest state and the last commit is always the last thing saved.
+// Everything pushed before destruction is saved.
 class SaveThread
 {
 public:
-	SaveThread();
+	SaveThread(int nWorkers = 2);
 	~SaveThread();
 
 	static SaveThread* Instance() { return s_instance; }
 
 	void Push(const LiveGame& game);
-	const LiveGame* Pop();
+	bool IsPending(const LiveGame& game) const; // Queued, or not yet on disk.
+
+private:
+	struct Node
+	{
+		const LiveGame* game;
+		Node* next;
+	};
 
 	void Go();
+	Node* TakeAll(); // Oldest first.
+	void SaveBatch(const std::vector<const LiveGame*>& games);
 
-private:
-	std::mutex _queueMutex, _cvMutex;
-	std::deque<const LiveGame*> _queue;
+	std::atomic<Node*> _head; // Newest first.
+	std::mutex _wakeMutex;
 	std::condition_variable _cv;
-	bool _abort;
-	std::thread _worker;
+	bool _abort; // Guarded by _wakeMutex.
+	WorkerPool _workers;
+	std::thread _collector;
 	static SaveThread* s_instance;
 };
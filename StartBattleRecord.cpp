@@ -33,10 +33,10 @@ void StartBattleRecord::Apply(bool bDo, const Game& game, GameState& gameState)
 
 void StartBattleRecord::Update(const Game& game, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateShowCombat(game, game.HasBattle()));
+	context.SendSharedMessage<Output::UpdateShowCombat>("", game, game.HasBattle());
 	
 	if (game.HasBattle())
-		context.SendMessage(Output::UpdateCombat(game, game.GetBattle()));
+		context.SendSharedMessage<Output::UpdateCombat>("", game, game.GetBattle());
 }
 
 std::string StartBattleRecord::GetMessage(const Game& game) const
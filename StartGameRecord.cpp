@@ -37,8 +37,8 @@ void StartGameRecord::Apply(bool bDo, const Game& game, GameState& gameState)
 
 void StartGameRecord::Update(const Game& game, const RecordContext& context) const
 {
-	context.SendMessage(Output::UpdateRound(game));
-	context.SendMessage(Output::UpdateTechnologies(game));
+	context.SendSharedMessage<Output::UpdateRound>("", game);
+	context.SendSharedMessage<Output::UpdateTechnologies>("", game);
 }
 
 std::string StartGameRecord::GetMessage(const Game& game) const
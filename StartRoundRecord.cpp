@@ -74,16 +74,16 @@ void StartRoundRecord::Update(const Game& game, const RecordContext& context) co
 	if (!m_teamData.empty())
 		for (auto& team : game.GetTeams())
 		{
-			context.SendMessage(Output::UpdatePassed(*team));
-			context.SendMessage(Output::UpdateInfluenceTrack(*team));
-			context.SendMessage(Output::UpdateActionTrack(*team));
-			context.SendMessage(Output::UpdateColonyShips(*team));
-			context.SendMessage(Output::UpdateStorageTrack(*team));
+			context.SendSharedMessage<Output::UpdatePassed>(::EnumToString(team->GetColour()), *team);
+			context.SendSharedMessage<Output::UpdateInfluenceTrack>(::EnumToString(team->GetColour()), *team);
+			context.SendSharedMessage<Output::UpdateActionTrack>(::EnumToString(team->GetColour()), *team);
+			context.SendSharedMessage<Output::UpdateColonyShips>(::EnumToString(team->GetColour()), *team);
+			context.SendSharedMessage<Output::UpdateStorageTrack>(::EnumToString(team->GetColour()), *team);
 		}
 
-	context.SendMessage(Output::UpdateRound(game));
-	context.SendMessage(Output::UpdateTechnologies(game));
-	context.SendMessage(Output::UpdateScore(game, game.HasFinished()));
+	context.SendSharedMessage<Output::UpdateRound>("", game);
+	context.SendSharedMessage<Output::UpdateTechnologies>("", game);
+	context.SendSharedMessage<Output::UpdateScore>("", game, game.HasFinished());
 }
 
 std::string StartRoundRecord::GetMessage(const Game& game) const
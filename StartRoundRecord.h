@@ -12,6 +12,8 @@ class StartRoundRecord : public Record
 public:
 	StartRoundRecord();
 
+	int GetRound() const { return m_round; } // Only valid once done.
+
 	virtual void Save(Serial::SaveNode& node) const override;
 	virtual void Load(const Serial::LoadNode& node) override;
 
@@ -0,0 +1,16 @@
+#include "stdafx.h"
+#include "StateHash.h"
+
+// splitmix64 finaliser.
+uint64_t StateHash::Mix(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+	return x ^ (x >> 31);
+}
+
+uint64_t StateHash::GetKey(int a, int b, int c, int d, int e)
+{
+	return StateHash().Add(a).Add(b).Add(c).Add(d).Add(e).Get();
+}
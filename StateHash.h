@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 64-bit hash of game state, used to check that a record's Undo restores exactly what Do changed.
+// Keys are XORed in and out (Zobrist style), so incrementally hashed state costs O(1) per mutation.
+// Small state is hashed on demand in order with Add.
+class StateHash
+{
+public:
+	StateHash(uint64_t seed = 0) : m_hash(seed) {}
+
+	static uint64_t Mix(uint64_t x);
+	static uint64_t GetKey(int a, int b = 0, int c = 0, int d = 0, int e = 0);
+
+	uint64_t Get() const { return m_hash; }
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, StateHash&>::type Add(T val)
+	{
+		m_hash = Mix(m_hash ^ (uint64_t)static_cast<int64_t>(val));
+		return *this;
+	}
+
+	template <typename T1, typename T2>
+	StateHash& Add(const std::pair<T1, T2>& val) { return Add(val.first).Add(val.second); }
+
+	template <typename T>
+	StateHash& AddRange(const T& cntr)
+	{
+		Add((int)std::distance(std::begin(cntr), std::end(cntr)));
+		for (auto& val : cntr)
+			Add(val);
+		return *this;
+	}
+
+private:
+	uint64_t m_hash;
+};
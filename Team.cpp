@@ -27,6 +27,16 @@ void Team::SetState(TeamState& state)
 	state.SetTeam(*this);
 }
 
+// Called when our game unshares a TeamState. Other copies of the game state may share the same game.
+void Team::ReplaceState(const TeamState& oldState, TeamState& newState)
+{
+	if (m_state == &oldState)
+	{
+		m_state = &newState;
+		newState.SetTeam(*this);
+	}
+}
+
 bool Team::IsAssigned() const
 {
 	return m_colour != Colour::None;
@@ -60,6 +60,7 @@ public:
 	~Team();
 
 	void SetState(TeamState& state);
+	void ReplaceState(const TeamState& oldState, TeamState& newState);
 
 	void Assign(RaceType race, Colour colour, LiveGame& game);
 	bool IsAssigned() const;
@@ -100,7 +101,7 @@ public:
 
 	bool HasPassed() const { return m_state->m_bPassed; }
 
-	const Blueprint& GetBlueprint(ShipType s) const { return m_state->GetBlueprint(s); }
+	const Blueprint& GetBlueprint(ShipType s) const { return static_cast<const TeamState*>(m_state)->GetBlueprint(s); }
 	bool CanUseShipPart(ShipPart part) const;
 
 	static bool IsAncientAlliance(const Team* pTeam1, const Team* pTeam2);
@@ -3,11 +3,14 @@
 
 #include "Team.h"
 #include "Map.h"
+#include "StateHash.h"
 
 TeamState::TeamState() : m_nColonyShipsUsed(0), m_bPassed(false), m_victoryPointTiles(0)
 {
 	for (int i = 0; i < 4; ++i)
 		m_nShips[i] = 0;
+
+	m_repTrack.SetAllies(m_allies);
 }
 
 TeamState::TeamState(const TeamState& rhs) :
@@ -18,8 +21,10 @@ m_victoryPointTiles(rhs.m_victoryPointTiles), m_discoveredShipParts(rhs.m_discov
 	for (int i = 0; i < 4; ++i)
 	{
 		m_nShips[i] = rhs.m_nShips[i];
-		m_blueprints[i].reset(new Blueprint(*rhs.m_blueprints[i]));
+		m_blueprints[i] = rhs.m_blueprints[i];
 	}
+
+	m_repTrack.SetAllies(m_allies);
 }
 
 bool TeamState::operator==(const TeamState& rhs) const
@@ -49,6 +54,34 @@ bool TeamState::operator==(const TeamState& rhs) const
 	return false;
 }
 
+uint64_t TeamState::GetHash() const
+{
+	StateHash hash;
+	for (int i = 0; i < 4; ++i)
+	{
+		const ShipLayout& overlay = m_blueprints[i]->GetOverlay();
+		hash.Add(m_nShips[i]).Add(overlay.GetType()).Add(overlay.GetSlotCount());
+		for (int j = 0; j < overlay.GetSlotCount(); ++j)
+			hash.Add(overlay.GetSlot(j));
+	}
+
+	hash.AddRange(m_allies);
+	for (auto r : EnumRange<Resource>())
+		hash.Add(m_popTrack.GetCount(r));
+	hash.Add(m_infTrack.GetDiscCount()).Add(m_actionTrack.GetDiscCount());
+
+	hash.Add(m_repTrack.GetReputationTileCount());
+	for (int i = 0; i < m_repTrack.GetReputationTileCount(); ++i)
+		hash.Add(m_repTrack.GetReputationTile(i));
+
+	for (auto c : EnumRange<Technology::Class>())
+		hash.AddRange(m_techTrack.GetClass(c));
+
+	hash.AddRange(m_storage).AddRange(m_discoveredShipParts).AddRange(m_graveyard);
+	hash.Add(m_nColonyShipsUsed).Add(m_bPassed).Add(m_victoryPointTiles);
+	return hash.Get();
+}
+
 void TeamState::SetTeam(const Team& team)
 {
 	m_repTrack.SetTeam(team);
@@ -98,6 +131,15 @@ void TeamState::InitHex(const Team& team, const MapPos& pos, int rotation, Map&
 }
 
 Blueprint& TeamState::GetBlueprint(ShipType s)
+{
+	VERIFY_MODEL(int(s) >= 0 && s != ShipType::_Count);
+	auto& blueprint = m_blueprints[int(s)];
+	if (blueprint.use_count() > 1)
+		blueprint = std::make_shared<Blueprint>(*blueprint);
+	return *blueprint;
+}
+
+const Blueprint& TeamState::GetBlueprint(ShipType s) const
 {
 	VERIFY_MODEL(int(s) >= 0 && s != ShipType::_Count);
 	return *m_blueprints[int(s)];
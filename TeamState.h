@@ -10,6 +10,7 @@
 #include "Types.h"
 
 #include <array>
+#include <cstdint>
 #include <set>
 
 class Team;
@@ -19,7 +20,6 @@ class MapPos;
 enum class Colour;
 enum class ShipPart;
 
-DEFINE_UNIQUE_PTR(Blueprint)
 
 class TeamState
 {
@@ -27,11 +27,13 @@ public:
 	TeamState();
 	TeamState(const TeamState& rhs);
 	bool operator==(const TeamState& rhs) const;
+	uint64_t GetHash() const; // Covers the same state as operator==.
 
 	void Init(const Team& team, const MapPos& pos, int rotation, Map& map, const std::vector<int>& repTiles);
 	void SetTeam(const Team& team);
 
-	Blueprint& GetBlueprint(ShipType s);
+	Blueprint& GetBlueprint(ShipType s); // Unshares the blueprint.
+	const Blueprint& GetBlueprint(ShipType s) const;
 	Storage& GetStorage() { return m_storage; }
 	PopulationTrack& GetPopulationTrack() { return m_popTrack; }
 	ReputationTrack& GetReputationTrack() { return m_repTrack; }
@@ -60,7 +62,7 @@ public:
 
 	SquareCounts m_graveyard;
 
-	std::array<BlueprintPtr, 4> m_blueprints;
+	std::array<std::shared_ptr<Blueprint>, 4> m_blueprints; // Shared between copies until written to.
 	int m_nShips[4];
 
 	std::set<ShipPart> m_discoveredShipParts;
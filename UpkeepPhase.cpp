@@ -42,7 +42,7 @@ void UpkeepPhase::Init(CommitSession& session)
 	auto& game = session.GetGame();
 	std::set<Colour> influenceableHexes; // Team -> hex IDs.
 
-	for (auto& pair : game.GetMap().GetHexes())
+	for (auto pair : game.GetMap().GetHexes())
 	{
 		auto& hex = pair.second;
 
@@ -8,10 +8,45 @@
 #include "Player.h"
 #include "Players.h"
 #include "HTMLServer.h"
+#include "LiveGame.h"
+#include "ReviewGame.h"
+#include "BinaryCodec.h"
+#include "Games.h"
 
-WSServer::WSServer(Controller& controller) : MongooseServer(8998), m_controller(controller)
+const std::chrono::minutes WSServer::HibernateAfter(30);
+const std::chrono::minutes WSServer::HibernateInterval(1);
+
+WSServer::WSServer(Controller& controller) : MongooseServer(8998), m_controller(controller), m_bStopping(false)
 {
 	controller.SetServer(this);
+	m_hibernateThread = std::thread(&WSServer::HibernateThread, this);
+}
+
+WSServer::~WSServer()
+{
+	{
+		LOCK(m_hibernateMutex);
+		m_bStopping = true;
+	}
+	m_hibernateCV.notify_all();
+	m_hibernateThread.join();
+}
+
+// Idle games nobody's connected to are unloaded until someone enters them again.
+void WSServer::HibernateThread()
+{
+	std::unique_lock<std::mutex> lock(m_hibernateMutex);
+	while (!m_hibernateCV.wait_for(lock, HibernateInterval, [&] { return m_bStopping; }))
+	{
+		LOCK(m_lobbyMutex);
+
+		std::set<int> inUse;
+		for (auto* pPlayer : m_players)
+			if (const Game* pGame = pPlayer->GetCurrentGame())
+				inUse.insert(pGame->IsLive() ? pGame->GetID() : static_cast<const ReviewGame*>(pGame)->GetLiveGameID());
+
+		Games::Hibernate(inUse, HibernateAfter);
+	}
 }
 
 bool WSServer::OnWebSocketConnect(const std::string& url, const StringMap& cookies)
@@ -29,27 +64,49 @@ void WSServer::OnWebSocketReady(ClientID client, const std::string& url)
 	std::cout << "INFO: Client connected: " << client << std::endl;
 }
 
-void WSServer::OnWebSocketMessage(ClientID client, const std::string& message)
+// Lobby messages hold the lobby lane, then the lane of the game they touch. 
+// Other messages only hold their game's lane, so they never wait for messages for other games. 
+void WSServer::LockLanes(const Input::Message& msg, const Player& player, Lock& lobbyLock, Lock& gameLock)
 {
-	LOCK(m_mutex); // Only process 1 message at a time. 
+	if (msg.IsLobbyMessage())
+		lobbyLock = Lock(m_lobbyMutex);
+
+	// The player's game may have changed in the lobby lane while we waited for its lane.
+	const LiveGame* pGame = msg.GetLaneGame(player);
+	while (pGame)
+	{
+		gameLock = Lock(pGame->GetLaneMutex());
+		const LiveGame* pLocked = pGame;
+		pGame = msg.GetLaneGame(player);
+		if (pGame == pLocked)
+		{
+			pGame->Touch();
+			break;
+		}
+		gameLock.unlock();
+	}
+}
+
+void WSServer::OnWebSocketMessage(ClientID client, const std::string& message, bool bBinary)
+{
+	Lock lobbyLock, gameLock; // Still held in the exception handler.
 
 	Player* player = nullptr;
 	try 
 	{
-		if (const Input::MessagePtr pMsg = Input::CreateMessage(message))
+		if (const Input::MessagePtr pMsg = Input::CreateMessage(bBinary ? BinaryCodec::Decode(message) : message))
 		{
 			if (auto pRegister = dynamic_cast<const Input::Register*>(pMsg.get()))
 			{
-				RegisterPlayer(client, Players::Get(pRegister->GetPlayerID()));
+				Player& newPlayer = Players::Get(pRegister->GetPlayerID());
+				LockLanes(*pMsg, newPlayer, lobbyLock, gameLock);
+				RegisterPlayer(client, newPlayer, *pRegister);
 			}
-			else
+			else if (Player* pPlayer = FindPlayer(client))
 			{
-				auto i = m_mapClientToPlayer.find(client);
-				if (i != m_mapClientToPlayer.end())
-				{
-					player = i->second;
-					m_controller.OnMessage(pMsg, *player);
-				}
+				LockLanes(*pMsg, *pPlayer, lobbyLock, gameLock);
+				player = pPlayer;
+				m_controller.OnMessage(pMsg, *player);
 			}
 		}
 		else
@@ -67,49 +124,76 @@ void WSServer::OnWebSocketMessage(ClientID client, const std::string& message)
 				m_controller.ClearQueuedMessages();
 				//m_controller.SendUpdateGame(*game); // Uh oh! Can trigger exceptionception.
 				m_controller.SendMessage(Output::AddLog(0, error), *game);
-				m_controller.SendQueuedMessages();
 			}
 		}
 	}
 
+	// In the same frame as the updates.
 	if (player)
-		SendMessage(Output::Response(), *player);
+		m_controller.SendMessage(Output::Response(), *player);
+	m_controller.SendQueuedMessages();
 }
 
 void WSServer::OnWebSocketDisconnect(ClientID client)
 {
-	LOCK(m_mutex);
+	LOCK(m_lobbyMutex);
 	UnregisterPlayer(client);
 }
 
-void WSServer::RegisterPlayer(ClientID client, Player& player)
+Player* WSServer::FindPlayer(ClientID client) const
+{
+	LOCK(m_mutex);
+	auto i = m_mapClientToPlayer.find(client);
+	return i == m_mapClientToPlayer.end() ? nullptr : i->second;
+}
+
+void WSServer::RegisterPlayer(ClientID client, Player& player, const Input::Register& msg)
 {
-	auto i = m_mapPlayerToClient.find(&player);
-	if (i != m_mapPlayerToClient.end())
-		if (UnregisterClient(i->second, true))
-			UnregisterPlayer(i->second);
+	ClientID oldClient = 0;
+	{
+		LOCK(m_mutex);
+		auto i = m_mapPlayerToClient.find(&player);
+		if (i != m_mapPlayerToClient.end())
+			oldClient = i->second;
+	}
+	if (oldClient && UnregisterClient(oldClient, true))
+		UnregisterPlayer(oldClient);
 		
-	m_mapPlayerToClient[&player] = client;
-	m_mapClientToPlayer[client] = &player;
-	m_players.insert(&player);
+	{
+		LOCK(m_mutex);
+		m_mapPlayerToClient[&player] = client;
+		m_mapClientToPlayer[client] = &player;
+		m_players.insert(&player);
+		if (msg.IsBinary())
+			m_binaryClients.insert(client);
+	}
+
+	if (msg.WantsDeflate() && !EnableDeflate(client))
+		std::cout << "INFO: Deflate requested but not available: " << client << std::endl;
+
+	// Before anything the client needs it to decode.
+	if (msg.IsBinary())
+		__super::SendMessage(client, Output::UpdateCodec(BinaryCodec::GetDictionary()).GetXML());
 
 	std::cout << "INFO: Client registered: " << client << " -> " << player.GetName() << std::endl;
-	m_controller.OnPlayerConnected(player);
+	m_controller.OnPlayerConnected(player, msg.GetEpoch(), msg.GetLastSeq());
 }
 
 
 void WSServer::UnregisterPlayer(ClientID client)
 {
-	auto i = m_mapClientToPlayer.find(client);
-	if (i == m_mapClientToPlayer.end())
+	Player* pPlayer = FindPlayer(client);
+	if (!pPlayer)
 		std::cerr << "ERROR: Unregistered client disconnected: " << client << std::endl;
 	else
 	{
-		Player* pPlayer = i->second;
 		std::cout << "INFO: Client disconnected: " << client << std::endl;
 		m_controller.OnPlayerDisconnected(*pPlayer);
+
+		LOCK(m_mutex);
 		m_mapPlayerToClient.erase(pPlayer);
 		m_mapClientToPlayer.erase(client);
+		m_binaryClients.erase(client);
 		m_players.erase(pPlayer);
 	}
 }
@@ -124,21 +208,50 @@ void WSServer::BroadcastMessage(const Output::Message& msg) const
 	return BroadcastMessage(msg.GetXML());
 }
 
-bool WSServer::SendMessage(const std::string& msg, const Player& player) const
+bool WSServer::IsBinary(const Player& player) const
 {
+	LOCK(m_mutex);
 	auto i = m_mapPlayerToClient.find(const_cast<Player*>(&player));
-	if (i == m_mapPlayerToClient.end())
-		return false;
+	return i != m_mapPlayerToClient.end() && m_binaryClients.count(i->second);
+}
 
-	__super::SendMessage(i->second, msg);
+bool WSServer::SendMessage(const std::string& msg, const Player& player, const std::string& binary) const
+{
+	ClientID client = 0;
+	bool bBinary = false;
+	{
+		LOCK(m_mutex);
+		auto i = m_mapPlayerToClient.find(const_cast<Player*>(&player));
+		if (i == m_mapPlayerToClient.end())
+			return false;
+		client = i->second;
+		bBinary = m_binaryClients.count(client) > 0;
+	}
+
+	if (bBinary)
+		__super::SendMessage(client, binary.empty() ? BinaryCodec::Encode(msg) : binary, true);
+	else
+		__super::SendMessage(client, msg);
 
 	return true;
 }
 
 void WSServer::BroadcastMessage(const std::string& msg) const
 {
+	std::string binary; // Encoded on demand.
+
+	LOCK(m_mutex);
 	for (auto& i : m_mapClientToPlayer)
-		__super::SendMessage(i.first, msg);
+	{
+		if (!m_binaryClients.count(i.first))
+			__super::SendMessage(i.first, msg);
+		else
+		{
+			if (binary.empty())
+				binary = BinaryCodec::Encode(msg);
+			__super::SendMessage(i.first, binary, true);
+		}
+	}
 }
 
 std::string WSServer::GetErrorMessage(const std::string& what, ClientID client)
@@ -150,9 +263,8 @@ std::string WSServer::GetErrorMessage(const std::string& what, ClientID client)
 	{
 		ss << " [client: ";
 
-		auto i = m_mapClientToPlayer.find(client);
-		if (i != m_mapClientToPlayer.end())
-			ss << i->second->GetName();
+		if (Player* pPlayer = FindPlayer(client))
+			ss << pPlayer->GetName();
 		else
 			ss << client;
 
@@ -2,38 +2,58 @@
 
 #include "MongooseServer.h"
 
+#include <condition_variable>
 #include <map>
+#include <thread>
 
 class Controller;
 class Player;
 
 namespace Output { class Message; }
+namespace Input { class Message; class Register; }
 
 class WSServer : public MongooseServer
 {
 public:
 	WSServer(Controller& controller);
+	virtual ~WSServer();
 	virtual bool OnWebSocketConnect(const std::string& url, const StringMap& cookies) override;
 	virtual void OnWebSocketReady(ClientID client, const std::string& url) override;
-	virtual void OnWebSocketMessage(ClientID client, const std::string& message) override;
+	virtual void OnWebSocketMessage(ClientID client, const std::string& message, bool bBinary) override;
 	virtual void OnWebSocketDisconnect(ClientID client) override;
 
 	bool SendMessage(const Output::Message& msg, const Player& player) const;
-	bool SendMessage(const std::string& msg, const Player& player) const;
+	bool SendMessage(const std::string& msg, const Player& player, const std::string& binary = std::string()) const; // binary: msg encoded, if we have it.
+	bool IsBinary(const Player& player) const;
 	void BroadcastMessage(const Output::Message& msg) const;
 	void BroadcastMessage(const std::string& msg) const;
 
 	const std::set<Player*>& GetPlayers() const { return m_players; }
 
 private:
-	void RegisterPlayer(ClientID client, Player& player);
+	typedef std::unique_lock<std::mutex> Lock;
+
+	void LockLanes(const Input::Message& msg, const Player& player, Lock& lobbyLock, Lock& gameLock);
+	Player* FindPlayer(ClientID client) const;
+	void RegisterPlayer(ClientID client, Player& player, const Input::Register& msg);
 	void UnregisterPlayer(ClientID client);
 	std::string GetErrorMessage(const std::string& what, ClientID client = 0);
+	void HibernateThread();
+
+	static const std::chrono::minutes HibernateAfter;
+	static const std::chrono::minutes HibernateInterval;
 
 	std::map<ClientID, Player*> m_mapClientToPlayer;
 	std::map<Player*, ClientID> m_mapPlayerToClient;
-	std::set<Player*> m_players;
-	mutable std::mutex m_mutex;
+	std::set<ClientID> m_binaryClients; // Registered for BinaryCodec messages.
+	std::set<Player*> m_players; // Only modified in the lobby lane.
+	mutable std::mutex m_mutex; // Guards the client maps.
+	std::mutex m_lobbyMutex; // The lobby lane.
 
 	Controller& m_controller;
+
+	std::thread m_hibernateThread;
+	std::mutex m_hibernateMutex;
+	std::condition_variable m_hibernateCV;
+	bool m_bStopping;
 };
@@ -0,0 +1,80 @@
+#include "stdafx.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int nThreads) : m_nBusy(0), m_bAbort(false)
+{
+	if (nThreads <= 0)
+		nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	for (int i = 0; i < nThreads; ++i)
+		m_threads.push_back(std::thread(&WorkerPool::Go, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bAbort = true;
+	}
+	m_cvTask.notify_all();
+
+	for (auto& t : m_threads)
+		t.join();
+}
+
+void WorkerPool::Push(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_cvTask.notify_one();
+}
+
+void WorkerPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cvIdle.wait(lock, [&] { return m_tasks.empty() && !m_nBusy; });
+
+	if (m_pException)
+	{
+		auto pException = m_pException;
+		m_pException = nullptr;
+		std::rethrow_exception(pException);
+	}
+}
+
+void WorkerPool::Go()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		// Finish queued tasks before aborting.
+		m_cvTask.wait(lock, [&] { return m_bAbort || !m_tasks.empty(); });
+		if (m_tasks.empty())
+			return;
+
+		auto task = std::move(m_tasks.front());
+		m_tasks.pop_front();
+		++m_nBusy;
+
+		lock.unlock();
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> exceptionLock(m_mutex);
+			if (!m_pException)
+				m_pException = std::current_exception();
+		}
+		lock.lock();
+
+		--m_nBusy;
+		if (m_tasks.empty() && !m_nBusy)
+			m_cvIdle.notify_all();
+	}
+}
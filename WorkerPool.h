@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs tasks on a fixed set of threads. 
+// The first exception thrown by a task is rethrown from Wait.
+class WorkerPool
+{
+public:
+	WorkerPool(int nThreads = 0); // 0: one per hardware thread.
+	~WorkerPool();
+
+	void Push(std::function<void()> task);
+	void Wait();
+
+	int GetThreadCount() const { return (int)m_threads.size(); }
+
+private:
+	void Go();
+
+	std::mutex m_mutex;
+	std::condition_variable m_cvTask, m_cvIdle;
+	std::deque<std::function<void()>> m_tasks;
+	int m_nBusy;
+	bool m_bAbort;
+	std::exception_ptr m_pException;
+	std::vector<std::thread> m_threads;
+};
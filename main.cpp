@@ -4,15 +4,25 @@
 #include "Controller.h"
 #include "Players.h"
 #include "Games.h"
+#include "GameDirectory.h"
+#include "LiveGame.h"
 #include "SaveThread.h"
+#include "DurableFile.h"
 #include "Test.h"
 
-int main(void) 
+int main(int argc, char* argv[]) 
 {
+	for (int i = 1; i < argc; ++i)
+		if (std::string(argv[i]) == "-audit")
+			LiveGame::SetAudit(true); // Replay every record on load and deep-compare states instead of hashes.
+		else if (std::string(argv[i]) == "-commit_window" && i + 1 < argc)
+			DurableFile::SetWindow(std::chrono::milliseconds(std::atoi(argv[++i]))); // How long a save waits for others to flush with.
+
 	Players::Load();
 	Games::Load(); 
 
 	Test::Run();
+	GameDirectory::Build();
 
 	Players::RejoinCurrentGame();
 
@@ -0,0 +1,184 @@
+// The server's compact binary message format: see BinaryCodec.h.
+var Codec = {}
+
+Codec.Tag = { Null: 0, False: 1, True: 2, Int: 3, Double: 4, String: 5, Word: 6, Array: 7, Object: 8, Points: 9 }
+Codec.supported = 'TextEncoder' in window && 'TextDecoder' in window
+Codec._words = null // From the server when we register; we send JSON until then.
+Codec._indices = Object.create(null) // No prototype, so "in" only finds words.
+
+Codec.IsReady = function()
+{
+	return Codec._words != null
+}
+
+Codec.SetWords = function(words)
+{
+	Codec._words = words
+	Codec._indices = Object.create(null)
+	if (words)
+		for (var i = 0; i < words.length; ++i)
+			Codec._indices[words[i]] = i
+}
+
+Codec.Decode = function(buffer)
+{
+	var bytes = new Uint8Array(buffer)
+	var view = new DataView(buffer)
+	var decoder = new TextDecoder()
+	var pos = 0
+
+	// Arithmetic rather than bitwise ops, which are only 32 bit.
+	function ReadVarint()
+	{
+		var n = 0, scale = 1, b
+		do
+		{
+			b = bytes[pos++]
+			n += (b & 0x7f) * scale
+			scale *= 128
+		} while (b & 0x80)
+		return n
+	}
+
+	function ReadInt()
+	{
+		var n = ReadVarint()
+		return n % 2 ? -(n + 1) / 2 : n / 2
+	}
+
+	function ReadString()
+	{
+		var len = ReadVarint()
+		var str = decoder.decode(bytes.subarray(pos, pos + len))
+		pos += len
+		return str
+	}
+
+	function ReadValue()
+	{
+		switch (bytes[pos++])
+		{
+		case Codec.Tag.Null: return null
+		case Codec.Tag.False: return false
+		case Codec.Tag.True: return true
+		case Codec.Tag.Int: return ReadInt()
+		case Codec.Tag.Double: pos += 8; return view.getFloat64(pos - 8, true)
+		case Codec.Tag.String: return ReadString()
+		case Codec.Tag.Word: return Codec._words[ReadVarint()]
+		case Codec.Tag.Array:
+			var array = []
+			for (var i = 0, count = ReadVarint(); i < count; ++i)
+				array.push(ReadValue())
+			return array
+		case Codec.Tag.Object:
+			var obj = {}
+			for (var i = 0, count = ReadVarint(); i < count; ++i)
+			{
+				var key = ReadValue()
+				obj[key] = ReadValue()
+			}
+			return obj
+		case Codec.Tag.Points:
+			var points = []
+			for (var i = 0, count = ReadVarint(); i < count; ++i)
+			{
+				var x = ReadInt()
+				points.push({ x: x, y: ReadInt() })
+			}
+			return points
+		}
+		Assert(false, 'Codec.Decode: bad tag')
+	}
+
+	return ReadValue()
+}
+
+Codec.Encode = function(value)
+{
+	var bytes = []
+	var encoder = new TextEncoder()
+
+	function WriteVarint(n)
+	{
+		for (; n >= 0x80; n = Math.floor(n / 128))
+			bytes.push(n % 128 | 0x80)
+		bytes.push(n)
+	}
+
+	function WriteInt(n)
+	{
+		WriteVarint(n < 0 ? -2 * n - 1 : 2 * n)
+	}
+
+	function WriteString(str)
+	{
+		if (str in Codec._indices)
+		{
+			bytes.push(Codec.Tag.Word)
+			WriteVarint(Codec._indices[str])
+			return
+		}
+		var utf8 = encoder.encode(str)
+		bytes.push(Codec.Tag.String)
+		WriteVarint(utf8.length)
+		for (var i = 0; i < utf8.length; ++i)
+			bytes.push(utf8[i])
+	}
+
+	function IsPoint(obj)
+	{
+		return obj && typeof obj == 'object' && Object.keys(obj).length == 2 && Number.isInteger(obj.x) && Number.isInteger(obj.y)
+	}
+
+	function WriteValue(value)
+	{
+		if (value == null)
+			bytes.push(Codec.Tag.Null)
+		else if (typeof value == 'boolean')
+			bytes.push(value ? Codec.Tag.True : Codec.Tag.False)
+		else if (typeof value == 'number')
+		{
+			if (Number.isInteger(value))
+			{
+				bytes.push(Codec.Tag.Int)
+				WriteInt(value)
+			}
+			else
+			{
+				var view = new DataView(new ArrayBuffer(8))
+				view.setFloat64(0, value, true)
+				bytes.push(Codec.Tag.Double)
+				for (var i = 0; i < 8; ++i)
+					bytes.push(view.getUint8(i))
+			}
+		}
+		else if (typeof value == 'string')
+			WriteString(value)
+		else if (Array.isArray(value))
+		{
+			if (value.length && value.every(IsPoint))
+			{
+				bytes.push(Codec.Tag.Points)
+				WriteVarint(value.length)
+				value.forEach(function(pt) { WriteInt(pt.x); WriteInt(pt.y) })
+			}
+			else
+			{
+				bytes.push(Codec.Tag.Array)
+				WriteVarint(value.length)
+				value.forEach(WriteValue)
+			}
+		}
+		else
+		{
+			// Like JSON.stringify, skip undefined members.
+			var keys = Object.keys(value).filter(function(key) { return value[key] !== undefined })
+			bytes.push(Codec.Tag.Object)
+			WriteVarint(keys.length)
+			keys.forEach(function(key) { WriteString(key); WriteValue(value[key]) })
+		}
+	}
+
+	WriteValue(value)
+	return new Uint8Array(bytes)
+}
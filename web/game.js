@@ -9,6 +9,12 @@ data.current_team_id = null
 data.current_action_elem = null
 data.action = null
 data.ping_timer_id = 0
+data.reconnect_delay = 0
+data.epoch = 0 // Identifies the server run that numbered the frames. 
+data.last_seq = 0 // Of the last frame, so we only get what we missed when we reconnect.
+data.inflater = null // For this connection, if we can inflate.
+data.receiving = Promise.resolve() // Messages are handled in order, even if some take a while to inflate.
+data.game_list = new Map() // id:{game, group}, in display order.
 
 var _capturer = new Capturer()
 
@@ -130,21 +136,66 @@ function ClearSelect(select_elem)
 
 function OnMessage(msg)
 {
-	var obj = JSON.parse(msg.data);
+	var received
+	if (data.inflater && msg.data instanceof ArrayBuffer && Inflater.IsCompressed(msg.data))
+		received = data.inflater.Inflate(msg.data) // Now, so the inflater gets the messages in order.
+	else
+		received = Promise.resolve({ data: msg.data })
+
+	data.receiving = data.receiving
+		.then(function() { return received })
+		.then(function(message) { HandleMessage(message.data) })
+		.catch(function(e) { console.error(e) })
+}
+
+function HandleMessage(raw)
+{
+	var obj = raw instanceof ArrayBuffer ? Codec.Decode(raw) : JSON.parse(raw);
 	
+	// The server batches the messages for one action into a numbered frame.
+	if ('seq' in obj)
+	{
+		data.last_seq = obj.seq
+		obj.msgs.forEach(OnMessageObject)
+	}
+	else
+		OnMessageObject(obj)
+}
+
+function OnMessageObject(obj)
+{
 	if (obj.command)
 		OnCommand(obj.command)
 	else if ('response' in obj)
 		ShowBlanket(false)
 }
   
+function OnOpen()
+{
+	data.reconnect_delay = 0
+	document.getElementById('shroud').style.display = 'none'
+	SendRegister()
+}
+
 function OnClose()
 {
 	ShowBlanket(false)
 	document.getElementById('shroud').style.display = 'table' // For v centre
 
-	if (data.ping_timer_id)
-		window.clearInterval(data.ping_timer_id)
+	// Keep trying, less and less often.
+	data.reconnect_delay = Math.min(data.reconnect_delay ? data.reconnect_delay * 2 : 1000, 30000)
+	window.setTimeout(Connect, data.reconnect_delay)
+}
+
+function Connect()
+{
+	var url = webSocketURL + '/' + data.playerID;
+	ws = new WebSocket(url);
+	ws.binaryType = 'arraybuffer';
+	data.inflater = Inflater.IsSupported() ? new Inflater() : null;
+	ws.onopen = OnOpen;
+	ws.onmessage = OnMessage;
+	ws.onclose = OnClose;
 }
 
 function load()
@@ -153,13 +204,9 @@ function load()
 
 	if ("WebSocket" in window)
 	{
-		var url = webSocketURL + '/' + data.playerID;
-		ws = new WebSocket(url);
-		ws.onopen = function() { SendRegister(); }
-		ws.onmessage = OnMessage;
-		ws.onclose = OnClose;
+		Connect()
 
-		data.ping_timer_id = window.setInterval(function() { ws.send('') }, 30000);
+		data.ping_timer_id = window.setInterval(function() { if (ws.readyState == WebSocket.OPEN) ws.send('') }, 30000);
 	}
 	else
 	{
@@ -0,0 +1,83 @@
+// Inflates the server's compressed messages (see MongooseServer::CompressMessage), in order, sharing one 
+// deflate context per connection as in permessage-deflate.
+var Inflater = function()
+{
+	this._stream = new DecompressionStream('deflate-raw')
+	this._writer = this._stream.writable.getWriter()
+	this._reader = this._stream.readable.getReader()
+	this._pending = new Uint8Array(0) // Output we've read beyond the current message.
+	this._queue = Promise.resolve() // Each message is inflated once the one before it has been read.
+}
+
+Inflater.IsSupported = function()
+{
+	try
+	{
+		new DecompressionStream('deflate-raw')
+		return true
+	}
+	catch (e)
+	{
+		return false
+	}
+}
+
+Inflater.IsCompressed = function(buffer)
+{
+	return buffer.byteLength > 0 && new Uint8Array(buffer, 0, 1)[0] >= 0xfe
+}
+
+// Resolves to { data: string or ArrayBuffer, binary: bool }, as the message was before it was compressed.
+// Calls can overlap: they share the stream and _pending, so each one waits for the last.
+Inflater.prototype.Inflate = function(buffer)
+{
+	var self = this
+	var result = this._queue.then(function() { return self._Inflate(buffer) })
+	this._queue = result.catch(function() {})
+	return result
+}
+
+Inflater.prototype._Inflate = function(buffer)
+{
+	var bytes = new Uint8Array(buffer)
+	var binary = bytes[0] == 0xff
+	var size = 0, scale = 1, pos = 1, b
+	do
+	{
+		b = bytes[pos++]
+		size += (b & 0x7f) * scale
+		scale *= 128
+	} while (b & 0x80)
+
+	// Put back the sync flush tail.
+	var input = new Uint8Array(bytes.length - pos + 4)
+	input.set(bytes.subarray(pos))
+	input.set([0, 0, 0xff, 0xff], input.length - 4)
+	this._writer.write(input)
+
+	return this._Read(size).then(function(out)
+	{
+		return { data: binary ? out.buffer : new TextDecoder().decode(out), binary: binary }
+	})
+}
+
+Inflater.prototype._Read = function(size)
+{
+	if (this._pending.length >= size)
+	{
+		var out = this._pending.slice(0, size)
+		this._pending = this._pending.slice(size)
+		return Promise.resolve(out)
+	}
+
+	var self = this
+	return this._reader.read().then(function(result)
+	{
+		Assert(!result.done, 'Inflater: stream ended')
+		var joined = new Uint8Array(self._pending.length + result.value.length)
+		joined.set(self._pending)
+		joined.set(result.value, self._pending.length)
+		self._pending = joined
+		return self._Read(size)
+	})
+}
@@ -51,6 +51,7 @@ function OnCommandShow(elem)
 		ShowElementById('choose_upkeep', false)
 
 		document.getElementById('output').innerText = ''
+		SetLogCursor(0)
 	}
 	
 	ShowElementById('exit_game_link', panel != 'game_list_panel')
@@ -62,8 +63,14 @@ function OnCommandUpdate(elem)
 {
 	var param = elem.param
 
-	if (param == "game_list")
+	if (param == "session")
+		data.epoch = elem.epoch
+	else if (param == "codec")
+		Codec.SetWords(elem.words)
+	else if (param == "game_list")
 		OnCommandUpdateGameList(elem)
+	else if (param == "game_list_entry")
+		OnCommandUpdateGameListEntry(elem)
 	else if (param == "lobby")
 		OnCommandUpdateLobby(elem)
 	else if (param == "lobby_controls")
@@ -94,6 +101,8 @@ function OnCommandUpdate(elem)
 		OnCommandUpdatePassed(elem)
 	else if (param == "map")
 		OnCommandUpdateMap(elem)
+	else if (param == "map_delta")
+		OnCommandUpdateMapDelta(elem)
 	else if (param == "review_ui")
 		OnCommandUpdateReviewUI(elem)
 	else if (param == "technologies")
@@ -112,6 +121,8 @@ function OnCommandUpdate(elem)
 		OnCommandUpdateCurrentPlayers(elem)
 	else if (param == "add_log")
 		OnCommandAddLog(elem)
+	else if (param == "prepend_log")
+		OnCommandPrependLog(elem)
 	else if (param == "remove_log")
 		OnCommandRemoveLog(elem)
 	else
@@ -182,7 +193,38 @@ function OnCommandChoose(elem)
 function OnCommandUpdateGameList(elem)
 {
 	Assert(elem.mine && elem.open && elem.other)
-	
+
+	// Keep the server's order; entries updated later stay where they are. 
+	data.game_list = new Map()
+	var AddGroup = function(games, group)
+	{
+		for (var i = 0, game; game = games[i]; ++i)
+			data.game_list.set(game.id, { game: game, group: group })
+	}
+	AddGroup(elem.mine, 'mine')
+	AddGroup(elem.open, 'open')
+	AddGroup(elem.other, 'other')
+
+	RenderGameList()
+}
+
+function OnCommandUpdateGameListEntry(elem)
+{
+	Assert(elem.game && elem.group)
+
+	data.game_list.set(elem.game.id, { game: elem.game, group: elem.group })
+	RenderGameList()
+}
+
+function RenderGameList()
+{
+	var GetGames = function(group)
+	{
+		var games = []
+		data.game_list.forEach(function(entry) { if (entry.group == group) games.push(entry.game) })
+		return games
+	}
+
 	var game_str = '<a href="Show Game" onclick="SendEnterGame({0});return false;">{1}</a>'
 	
 	var AddItem = function(tr)
@@ -220,9 +262,9 @@ function OnCommandUpdateGameList(elem)
 	AddItem(tr, 'Name')
 	AddItem(tr, 'Owner')
 
-	AddGames(elem.mine, 'My games:')
-	AddGames(elem.open, 'Open games:')
-	AddGames(elem.other, 'Other games:')
+	AddGames(GetGames('mine'), 'My games:')
+	AddGames(GetGames('open'), 'Open games:')
+	AddGames(GetGames('other'), 'Other games:')
 }
 
 function OnCommandUpdateLobby(elem)
@@ -408,6 +450,8 @@ function OnCommandUpdateVictoryTiles(elem)
 function OnCommandUpdateMap(elem)
 {
 	Map.Clear()
+	Map.version = elem.version
+	Map.fetching = false
 	
 	for (var i = 0, hex; hex = elem.hexes[i]; ++i)
 		Map.AddHex(hex.id, new Point(hex.x, hex.y), hex.rotation, hex.colour, hex.squares, hex.ships)
@@ -415,20 +459,48 @@ function OnCommandUpdateMap(elem)
 	Map.Draw()
 }
 
+function OnCommandUpdateMapDelta(elem)
+{
+	// We've missed a delta, so get the whole map. 
+	if (elem.base_version != Map.version)
+	{
+		if (!Map.fetching)
+			SendFetchMap()
+		Map.fetching = true
+		return
+	}
+
+	Map.version = elem.version
+
+	for (var i = 0, pos; pos = elem.removed[i]; ++i)
+		Map.RemoveHex(new Point(pos.x, pos.y))
+
+	for (var i = 0, hex; hex = elem.hexes[i]; ++i)
+	{
+		var pos = new Point(hex.x, hex.y)
+		Map.RemoveHex(pos)
+		Map.AddHex(hex.id, pos, hex.rotation, hex.colour, hex.squares, hex.ships)
+	}
+
+	Map.Draw()
+}
+
 function OnCommandUpdateReviewUI(elem)
 {
 	document.getElementById('retreat_review').disabled = !elem.can_retreat
 	document.getElementById('advance_review').disabled = !elem.can_advance
-	
-	var next_record_id = elem.next_record_id ? 'log_item_{0}'.format(elem.next_record_id) : null
 
+	var scrub = document.getElementById('review_scrub')
+	scrub.max = Math.max(0, elem.round_count - 1)
+	scrub.value = Math.max(0, elem.round)
+	document.getElementById('review_scrub_label').innerText = 'Round {0}/{1}'.format(Math.max(0, elem.round) + 1, elem.round_count)
+	
+	// The next record may be in a page we haven't fetched.
 	var div = document.getElementById('output')
-	var colour = "black"
 	for (var e = div.firstChild; e; e = e.nextSibling)
 	{
-		if (e.id == next_record_id)
-			colour = "gray"
-		e.style.color = colour
+		var id = Number(e.id.substr('log_item_'.length))
+		e.style.color = elem.next_record_id && id >= elem.next_record_id ? "gray" : "black"
 	}
 }
 
@@ -529,21 +601,55 @@ function OnCommandUpdateCurrentPlayers(elem)
 	UpdateTeamTabs()
 }
 
-function OnCommandAddLog(elem)
+function GetLogItemsHTML(items)
 {
 	var colour = IsElementVisible('review_ui') ? 'gray' : 'black'
 
-	var div = document.getElementById('output')
-	for (var i = 0, item; item = elem.items[i]; ++i)
+	var html = ''
+	for (var i = 0, item; item = items[i]; ++i)
 	{
 		var msg = EscapeHtml(item.message).replace('\n', '<br>')
-		var html = '<div id="log_item_{0}" style="color:{1}">'.format(item.id, item.id == 0 ? 'red' : colour) + msg + '<br></div>'
-		div.innerHTML += html
+		html += '<div id="log_item_{0}" style="color:{1}" onclick="OnClickLogItem({0})">'.format(item.id, item.id == 0 ? 'red' : colour) + msg + '<br></div>'
 	}
+	return html
+}
+
+// cursor: the ID to fetch earlier logs before, or 0 if there are none.
+function SetLogCursor(cursor)
+{
+	var link = document.getElementById('log_more')
+	link.dataset.cursor = cursor
+	ShowElementById('log_more', cursor != 0)
+}
+
+function OnCommandAddLog(elem)
+{
+	var div = document.getElementById('output')
+	div.innerHTML += GetLogItemsHTML(elem.items)
 	
+	if (elem.cursor)
+		SetLogCursor(elem.cursor)
+
 	div.scrollTop = div.scrollHeight;
 }
 
+function OnCommandPrependLog(elem)
+{
+	var div = document.getElementById('output')
+	var oldHeight = div.scrollHeight
+
+	div.innerHTML = GetLogItemsHTML(elem.items) + div.innerHTML
+	SetLogCursor(elem.cursor || 0)
+
+	div.scrollTop += div.scrollHeight - oldHeight // Keep the view still.
+}
+
+function OnClickLogItem(id)
+{
+	if (id && IsElementVisible('review_ui'))
+		SendSeekReviewRecord(id)
+}
+
 function OnCommandRemoveLog(elem)
 {
 	var span = document.getElementById('log_item_{0}'.format(elem.id))
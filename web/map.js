@@ -27,6 +27,8 @@ Map.img_explore = new Image()
 Map.img_explore.src = "/images/explore.png"
 
 Map._hexes = []
+Map.version = 0 // Of the server's map; see map_delta.
+Map.fetching = false
 
 Map.Hex = function(id, pos, rotation, team, squares, ships, onload) 
 {
@@ -354,6 +356,11 @@ Map.Clear = function()
 	Map._hexes = []
 }
 
+Map.RemoveHex = function(pos)
+{
+	Map._hexes = Map._hexes.filter(function(hex) { return !hex.pos.equals(pos) })
+}
+
 Map.AddHex = function(id, pos, rotation, team, squares, ships)
 {
 	Map._hexes.push(new Map.Hex(id, pos.Clone(), rotation, team, squares, ships, Map.DrawHexLayerSingle))
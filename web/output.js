@@ -5,8 +5,7 @@ function CreateCommandJSON(type)
 
 function SendJSON(json, noBlanket)
 {
-	var str = JSON.stringify(json)
-	ws.send(str)
+	ws.send(Codec.IsReady() ? Codec.Encode(json) : JSON.stringify(json))
 
 	if (!noBlanket)
 		ShowBlanket(true)
@@ -51,6 +50,20 @@ function SendRetreatReview()
 	SendJSON(CreateCommandJSON('retreat_review'))
 }
 
+function SendSeekReviewRound(round)
+{
+	var json = CreateCommandJSON('seek_review')
+	json.round = Number(round)
+	SendJSON(json)
+}
+
+function SendSeekReviewRecord(id)
+{
+	var json = CreateCommandJSON('seek_review')
+	json.record_id = id
+	SendJSON(json)
+}
+
 function SendStartGame()
 {
 	SendJSON(CreateCommandJSON('start_game'))
@@ -110,6 +123,16 @@ function SendRegister()
 	var json = CreateCommandJSON('register')
 	
 	json.player = data.playerID
+	json.binary = Codec.supported
+	json.deflate = data.inflater != null
+	Codec.SetWords(null) // The server sends them again.
+
+	// Resume where we left off, if we've been connected before.
+	if (data.epoch)
+	{
+		json.epoch = data.epoch
+		json.last_seq = data.last_seq
+	}
 
 	SendJSON(json, true)
 }
@@ -121,6 +144,18 @@ function SendAbort()
 	SendJSON(CreateCommandJSON('cmd_abort'))
 }
 
+function SendFetchMap()
+{
+	SendJSON(CreateCommandJSON('fetch_map'), true)
+}
+
+function SendFetchLogs()
+{
+	var json = CreateCommandJSON('fetch_logs')
+	json.before = Number(document.getElementById('log_more').dataset.cursor)
+	SendJSON(json)
+}
+
 function SendChat()
 {
 	var json = CreateCommandJSON('chat')